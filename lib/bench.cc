@@ -0,0 +1,465 @@
+#include <iostream>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include "zsdd.h"
+#include "zsdd_fnf.h"
+#include "zsdd_compiler.h"
+#include "zsdd_nodetable.h"
+#include "cache_table.h"
+
+using namespace std;
+using namespace zsdd;
+
+// benchmarks of the library, which write their results to stdout in json.
+// inputs are generated with fixed seeds, so that runs are comparable
+// between versions. every benchmark is run a number of times, and the
+// median and the minimum are reported.
+
+namespace {
+
+// results of benchmarks are written here, so that they are not optimized out.
+volatile long long sink;
+
+
+struct Timing {
+    double median;
+    double min;
+};
+
+
+Timing summarize(vector<double>& secs) {
+    sort(secs.begin(), secs.end());
+    return Timing{secs[secs.size() / 2], secs[0]};
+}
+
+
+double seconds(const function<void()>& f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double>(end - start).count();
+}
+
+
+// setup is run before each repetition, out of the measured time.
+Timing measure(const int repetitions, const function<void()>& f,
+               const function<void()>& setup = []() {}) {
+    vector<double> secs;
+    for (int i = 0; i < repetitions; i++) {
+        setup();
+        secs.push_back(seconds(f));
+    }
+    return summarize(secs);
+}
+
+
+string json_string(const string& s) {
+    string res = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') res += '\\';
+        res += c;
+    }
+    return res + "\"";
+}
+
+
+class JsonWriter {
+public:
+    explicit JsonWriter(ostream& os) : os_(os), num_micro_(0), num_macro_(0) {}
+
+    void micro(const string& name, const size_t ops, const Timing& t) {
+        os_ << (num_micro_++ == 0 ? "" : ",\n") << "    {\"name\": " << json_string(name)
+            << ", \"ops\": " << ops
+            << ", \"ns_per_op\": " << t.median * 1e9 / ops
+            << ", \"min_ns_per_op\": " << t.min * 1e9 / ops << "}";
+    }
+
+    void macro(const string& name, const string& vtree, const Zsdd& res, const Timing& t) {
+        os_ << (num_macro_++ == 0 ? "" : ",\n") << "    {\"name\": " << json_string(name)
+            << ", \"vtree\": " << json_string(vtree)
+            << ", \"msec\": " << t.median * 1e3
+            << ", \"min_msec\": " << t.min * 1e3
+            << ", \"nodes\": " << res.size()
+            << ", \"count\": " << json_string(res.count_solution_exact()) << "}";
+    }
+
+private:
+    ostream& os_;
+    size_t num_micro_;
+    size_t num_macro_;
+};
+
+
+// families of num_families random sets of variables in [first, last].
+vector<Zsdd> random_families(ZsddManager& mgr, mt19937_64& rng, const size_t num_families,
+                             const size_t num_sets, const int first, const int last) {
+    vector<Zsdd> res;
+    uniform_int_distribution<int> var(first, last);
+    for (size_t i = 0; i < num_families; i++) {
+        vector<vector<int>> sets(num_sets);
+        for (auto& s : sets) {
+            const int size = 1 + rng() % 6;
+            for (int k = 0; k < size; k++) s.push_back(var(rng));
+        }
+        res.push_back(mgr.make_zsdd_from_sets(sets));
+    }
+    return res;
+}
+
+
+// zsdd_apply through the operations of the manager. the cache is cleared
+// by gc() before every run, and the operands are applied pairwise.
+void bench_apply(JsonWriter& out, const int repetitions) {
+    const int num_vars = 32;
+    VTree vtree = VTree::construct_balanced_vtree(num_vars);
+    ZsddManager mgr(vtree, 1U << 20);
+    mt19937_64 rng(1);
+    const vector<Zsdd> fs = random_families(mgr, rng, 16, 200, 1, num_vars);
+    // orthogonal joins take families on disjoint variables.
+    const vector<Zsdd> lefts = random_families(mgr, rng, 16, 40, 1, num_vars / 2);
+    const vector<Zsdd> rights = random_families(mgr, rng, 16, 40, num_vars / 2 + 1, num_vars);
+    typedef function<Zsdd(const Zsdd&, const Zsdd&)> BinaryOp;
+    const vector<pair<string, BinaryOp>> binary_ops = {
+        {"union", [&mgr](const Zsdd& l, const Zsdd& r) { return mgr.zsdd_union(l, r); }},
+        {"intersection", [&mgr](const Zsdd& l, const Zsdd& r) { return mgr.zsdd_intersection(l, r); }},
+        {"difference", [&mgr](const Zsdd& l, const Zsdd& r) { return mgr.zsdd_difference(l, r); }},
+        {"orthogonal_join", [&mgr](const Zsdd& l, const Zsdd& r) { return mgr.zsdd_orthogonal_join(l, r); }},
+    };
+    for (const auto& op : binary_ops) {
+        const bool orthogonal = (op.first == "orthogonal_join");
+        const vector<Zsdd>& ls = orthogonal ? lefts : fs;
+        const vector<Zsdd>& rs = orthogonal ? rights : fs;
+        const Timing t = measure(repetitions, [&]() {
+                for (const auto& l : ls) {
+                    for (const auto& r : rs) {
+                        op.second(l, r);
+                    }
+                }
+            }, [&mgr]() { mgr.gc(); });
+        out.micro("zsdd_apply/" + op.first, ls.size() * rs.size(), t);
+    }
+    typedef function<Zsdd(const Zsdd&, const addr_t)> VarOp;
+    const vector<pair<string, VarOp>> var_ops = {
+        {"change", [&mgr](const Zsdd& z, const addr_t v) { return mgr.zsdd_change(z, v); }},
+        {"filter_contain", [&mgr](const Zsdd& z, const addr_t v) { return mgr.zsdd_filter_contain(z, v); }},
+        {"filter_not_contain", [&mgr](const Zsdd& z, const addr_t v) { return mgr.zsdd_filter_not_contain(z, v); }},
+    };
+    for (const auto& op : var_ops) {
+        const Timing t = measure(repetitions, [&]() {
+                for (const auto& z : fs) {
+                    for (int v = 1; v <= num_vars; v++) {
+                        op.second(z, v);
+                    }
+                }
+            }, [&mgr]() { mgr.gc(); });
+        out.micro("zsdd_apply/" + op.first, fs.size() * num_vars, t);
+    }
+}
+
+
+// the unique table: inserting new decompositions, and finding them again.
+void bench_make_or_find_decomp(JsonWriter& out, const int repetitions) {
+    const size_t num_decomps = 1U << 18;
+    const int num_literals = 64;
+    mt19937_64 rng(2);
+    vector<vector<ZsddElement>> decomps(num_decomps);
+    for (auto& d : decomps) {
+        const int size = 2 + rng() % 3;
+        for (int k = 0; k < size; k++) {
+            d.emplace_back(rng() % num_literals, rng() % num_literals);
+        }
+    }
+    vector<double> insert_secs;
+    vector<double> find_secs;
+    for (int i = 0; i < repetitions; i++) {
+        ZsddNodeTable table;
+        for (int l = 1; l <= num_literals; l++) {
+            table.make_or_find_literal(l, 0);
+        }
+        // decompositions are moved into the table.
+        vector<vector<ZsddElement>> first(decomps);
+        vector<vector<ZsddElement>> second(decomps);
+        insert_secs.push_back(seconds([&]() {
+                    for (auto& d : first) table.make_or_find_decomp(move(d), 1);
+                }));
+        find_secs.push_back(seconds([&]() {
+                    for (auto& d : second) table.make_or_find_decomp(move(d), 1);
+                }));
+    }
+    out.micro("make_or_find_decomp/insert", num_decomps, summarize(insert_secs));
+    out.micro("make_or_find_decomp/find", num_decomps, summarize(find_secs));
+}
+
+
+void bench_cache_table(JsonWriter& out, const int repetitions) {
+    const size_t num_ops = 1U << 22;
+    mt19937_64 rng(3);
+    vector<pair<addr_t, addr_t>> keys(num_ops);
+    for (auto& k : keys) {
+        k = make_pair(rng() % (1U << 20), rng() % (1U << 20));
+    }
+    CacheTable cache(1U << 20);
+    const Timing write = measure(repetitions, [&]() {
+            for (size_t i = 0; i < num_ops; i++) {
+                cache.write_cache(Operation::UNION, keys[i].first, keys[i].second, i);
+            }
+        });
+    out.micro("cache_table/write", num_ops, write);
+    const Timing read = measure(repetitions, [&]() {
+            addr_t sum = 0;
+            for (size_t i = 0; i < num_ops; i++) {
+                sum += cache.read_cache(Operation::UNION, keys[i].first, keys[i].second);
+            }
+            sink = sum;
+        });
+    out.micro("cache_table/read", num_ops, read);
+}
+
+
+void bench_get_depend_node(JsonWriter& out, const int repetitions) {
+    const unsigned int num_vars = 1024;
+    const size_t num_ops = 1U << 20;
+    const vector<pair<string, VTree>> vtrees = {
+        {"right_linear", VTree::construct_right_linear_vtree(num_vars)},
+        {"balanced", VTree::construct_balanced_vtree(num_vars)},
+    };
+    for (const auto& v : vtrees) {
+        mt19937_64 rng(4);
+        vector<pair<int, int>> pairs(num_ops);
+        for (auto& p : pairs) {
+            p = make_pair(rng() % v.second.size(), rng() % v.second.size());
+        }
+        const Timing t = measure(repetitions, [&]() {
+                long long sum = 0;
+                for (const auto& p : pairs) {
+                    sum += v.second.get_depend_node(p.first, p.second);
+                }
+                sink = sum;
+            });
+        out.micro("get_depend_node/" + v.first, num_ops, t);
+    }
+}
+
+
+void bench_count_solution(JsonWriter& out, const int repetitions, ZsddManager& mgr, const Zsdd& z,
+                          const string& name) {
+    const size_t num_ops = 100;
+    const Timing t = measure(repetitions, [&]() {
+            for (size_t i = 0; i < num_ops; i++) {
+                z.count_solution_exact();
+            }
+        });
+    out.micro("count_solution/" + name, num_ops, t);
+    // gc() drops the evaluation order, which is built again by the count.
+    // only the counts are timed.
+    vector<double> cold_secs;
+    for (int i = 0; i < repetitions; i++) {
+        double secs = 0;
+        for (size_t k = 0; k < num_ops; k++) {
+            mgr.gc();
+            secs += seconds([&z]() { z.count_solution_exact(); });
+        }
+        cold_secs.push_back(secs);
+    }
+    out.micro("count_solution_cold/" + name, num_ops, summarize(cold_secs));
+}
+
+
+// synthetic formulas.
+
+FnfFormula random_kcnf(const int num_vars, const int num_clauses, const int k, const uint64_t seed) {
+    mt19937_64 rng(seed);
+    FnfFormula f;
+    for (int i = 0; i < num_clauses; i++) {
+        vector<int> clause;
+        while (static_cast<int>(clause.size()) < k) {
+            const int v = 1 + rng() % num_vars;
+            bool found = false;
+            for (auto l : clause) found = found || abs(l) == v;
+            if (!found) clause.push_back((rng() % 2) ? v : -v);
+        }
+        f.add_clause(clause.begin(), clause.end());
+    }
+    f.set_num_variables(num_vars);
+    return f;
+}
+
+
+// num_holes + 1 pigeons in num_holes holes, which is unsatisfiable.
+FnfFormula pigeonhole(const int num_holes) {
+    const int num_pigeons = num_holes + 1;
+    auto var = [num_holes](const int p, const int h) { return p * num_holes + h + 1; };
+    FnfFormula f;
+    for (int p = 0; p < num_pigeons; p++) {
+        vector<int> clause;
+        for (int h = 0; h < num_holes; h++) clause.push_back(var(p, h));
+        f.add_clause(clause.begin(), clause.end());
+    }
+    for (int h = 0; h < num_holes; h++) {
+        for (int p = 0; p < num_pigeons; p++) {
+            for (int q = p + 1; q < num_pigeons; q++) {
+                const vector<int> clause = {-var(p, h), -var(q, h)};
+                f.add_clause(clause.begin(), clause.end());
+            }
+        }
+    }
+    f.set_num_variables(num_pigeons * num_holes);
+    return f;
+}
+
+
+// x1 -> x2 -> ... -> xn.
+FnfFormula chain(const int num_vars) {
+    FnfFormula f;
+    for (int v = 1; v < num_vars; v++) {
+        const vector<int> clause = {-v, v + 1};
+        f.add_clause(clause.begin(), clause.end());
+    }
+    f.set_num_variables(num_vars);
+    return f;
+}
+
+
+// independent sets of a width x height grid graph.
+FnfFormula grid(const int width, const int height) {
+    auto var = [width](const int x, const int y) { return y * width + x + 1; };
+    FnfFormula f;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (x + 1 < width) {
+                const vector<int> clause = {-var(x, y), -var(x + 1, y)};
+                f.add_clause(clause.begin(), clause.end());
+            }
+            if (y + 1 < height) {
+                const vector<int> clause = {-var(x, y), -var(x, y + 1)};
+                f.add_clause(clause.begin(), clause.end());
+            }
+        }
+    }
+    f.set_num_variables(width * height);
+    return f;
+}
+
+
+struct MacroInput {
+    string name;
+    ZsddCompiler::Form form;
+    FnfFormula formula;
+    string vtree_file_name; // compiled under this vtree too, if given.
+};
+
+
+Zsdd compile(ZsddManager& mgr, const MacroInput& input) {
+    ZsddCompiler compiler(mgr, input.form);
+    return compiler.add(input.formula);
+}
+
+
+void bench_macro(JsonWriter& out, const int repetitions, const vector<MacroInput>& inputs) {
+    for (const auto& input : inputs) {
+        const int num_vars = input.formula.num_variables();
+        vector<pair<string, VTree>> vtrees = {
+            {"right_linear", VTree::construct_right_linear_vtree(num_vars)},
+            {"balanced", VTree::construct_balanced_vtree(num_vars)},
+        };
+        if (input.vtree_file_name != "") {
+            vtrees.emplace_back("file", VTree::import_from_sdd_vtree_file(input.vtree_file_name));
+        }
+        for (const auto& v : vtrees) {
+            cerr << input.name << " (" << v.first << ")..." << endl;
+            ZsddManager mgr(v.second, 1U << 22);
+            Zsdd res = mgr.make_zsdd_empty();
+            // every run starts from an empty cache and unique table,
+            // which are cleared before the clock starts.
+            const Timing t = measure(repetitions, [&]() {
+                    res = compile(mgr, input);
+                }, [&]() {
+                    res = mgr.make_zsdd_empty();
+                    mgr.gc();
+                });
+            out.macro(input.name, v.first, res, t);
+        }
+    }
+}
+
+} // namespace
+
+
+void show_help_and_exit() {
+    cout << "zsdd_bench: benchmarks of the zsdd library (json to stdout)\n"
+         << "    -c FILE        also compile the CNF file (e.g., ../sample/cht.cnf)\n"
+         << "    -v FILE        also use the VTREE file for the CNF file\n"
+         << "    -n N           set number of runs of each benchmark (default is 5)\n"
+         << "    -h             show help message and exit\n";
+    exit(0);
+}
+
+
+int main(int argc, char** argv) {
+    int opt;
+    string cnf_file_name = "";
+    string vtree_file_name = "";
+    int repetitions = 5;
+    while ((opt = getopt(argc, argv, "c:v:n:h")) != -1) {
+        switch (opt) {
+        case 'c':
+            cnf_file_name = optarg;
+            break;
+        case 'v':
+            vtree_file_name = optarg;
+            break;
+        case 'n':
+            repetitions = max(1, stoi(optarg));
+            break;
+        case 'h':
+        default:
+            show_help_and_exit();
+            break;
+        }
+    }
+
+    vector<MacroInput> inputs = {
+        {"random_3cnf_n28_m84", ZsddCompiler::Form::CNF, random_kcnf(28, 84, 3, 5), ""},
+        {"random_3dnf_n32_m40", ZsddCompiler::Form::DNF, random_kcnf(32, 40, 3, 6), ""},
+        {"pigeonhole_h6", ZsddCompiler::Form::CNF, pigeonhole(6), ""},
+        {"chain_n500", ZsddCompiler::Form::CNF, chain(500), ""},
+        {"grid_8x8", ZsddCompiler::Form::CNF, grid(8, 8), ""},
+    };
+    if (cnf_file_name != "") {
+        FnfFormula f = FnfFormula::read_dimacs(cnf_file_name, 1);
+        const size_t slash = cnf_file_name.find_last_of('/');
+        const string name = cnf_file_name.substr(slash == string::npos ? 0 : slash + 1);
+        inputs.push_back(MacroInput{name, ZsddCompiler::Form::CNF, move(f), vtree_file_name});
+    }
+
+    JsonWriter out(cout);
+    cout.precision(6);
+    cout << "{\n  \"repetitions\": " << repetitions << ",\n  \"micro\": [\n";
+    cerr << "apply..." << endl;
+    bench_apply(out, repetitions);
+    cerr << "make_or_find_decomp..." << endl;
+    bench_make_or_find_decomp(out, repetitions);
+    cerr << "cache_table..." << endl;
+    bench_cache_table(out, repetitions);
+    cerr << "get_depend_node..." << endl;
+    bench_get_depend_node(out, repetitions);
+    {
+        const MacroInput& input = inputs.back();
+        VTree vtree = (input.vtree_file_name != "") ?
+            VTree::import_from_sdd_vtree_file(input.vtree_file_name) :
+            VTree::construct_right_linear_vtree(input.formula.num_variables());
+        ZsddManager mgr(vtree, 1U << 22);
+        const Zsdd z = compile(mgr, input);
+        cerr << "count_solution..." << endl;
+        bench_count_solution(out, repetitions, mgr, z, input.name);
+    }
+    cout << "\n  ],\n  \"macro\": [\n";
+    bench_macro(out, repetitions, inputs);
+    cout << "\n  ]\n}" << endl;
+    return 0;
+}
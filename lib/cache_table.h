@@ -10,22 +10,26 @@
 namespace zsdd {
 
 class CacheTable {
-    using cache_entry = std::tuple<Operation, addr_t, addr_t, addr_t>;
+    // entries written before the last clear_cache() have old generations.
+    using cache_entry = std::tuple<Operation, unsigned int, addr_t, addr_t, addr_t>;
 public:
 
-    CacheTable() : cache_table_(INIT_SIZE) {}
-    CacheTable(const int init_size) : cache_table_(init_size) {}    
+    CacheTable() : cache_table_(INIT_SIZE), generation_(0) {}
+    CacheTable(const int init_size) : cache_table_(init_size), generation_(0) {}    
 
     void write_cache(const Operation op, const addr_t lhs, 
                      const addr_t rhs, const addr_t res) {
         auto key = calc_key(op, lhs, rhs);
-        cache_table_[key] = std::make_tuple(op, lhs, rhs, res);
+        cache_table_[key] = std::make_tuple(op, generation_, lhs, rhs, res);
     }
 
 
+    // O(1) except when the generation wraps around, so that a large
+    // table can be cleared at every gc.
     void clear_cache() {
+        if (++generation_ != 0) return;
         for (auto it =  cache_table_.begin(); it != cache_table_.end(); ++it) {
-            *it = std::make_tuple(Operation::NULLOP, -1, -1, -1);
+            *it = std::make_tuple(Operation::NULLOP, 0U, -1, -1, -1);
         }
     }
 
@@ -34,9 +38,10 @@ public:
         auto res = cache_table_[key];
         
         if (std::get<0>(res) == op &&
-            std::get<1>(res) == lhs &&
-            std::get<2>(res) == rhs) {
-            return std::get<3>(res);
+            std::get<1>(res) == generation_ &&
+            std::get<2>(res) == lhs &&
+            std::get<3>(res) == rhs) {
+            return std::get<4>(res);
         }
         return ZSDD_NULL;
     }
@@ -57,6 +62,7 @@ private:
     const unsigned int TABLE_EXTEND_FACTOR = 2;
     const unsigned int INIT_SIZE = 1U<<8;
     std::vector<cache_entry> cache_table_;
+    unsigned int generation_;
 
     size_t calc_key(const Operation op, const addr_t lhs,  const addr_t rhs) {
         size_t key = 0;
@@ -7,24 +7,26 @@
 #include <unordered_set>
 #include <algorithm>
 #include <assert.h>
+#include <stdio.h>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include "zsdd.h"
+#include "zsdd_preprocess.h"
+#include "zsdd_fnf.h"
+#include "zsdd_frozen.h"
+#include "zsdd_server.h"
+#include "zsdd_snapshot.h"
 using namespace std;
 using namespace zsdd;
 
-std::vector<int> split(const std::string& input, char delimiter)
-{
-    std::istringstream stream(input);
-
-    std::string field;
-    std::vector<int> result;
-    while (std::getline(stream, field, delimiter)) {
-        result.push_back(stoi(field));
-    }
-    return result;
-}
-
-
+struct CompileOptions {
+    unsigned int num_threads;
+    // snapshots of the cnf compilation are written to this file, and the
+    // compilation resumes from it if it exists.
+    string checkpoint_file_name;
+};
 
 Zsdd make_power_set(const unordered_set<int>& ids, ZsddManager& mgr) {
     vector<int> ids_sort(ids.begin(), ids.end());
@@ -38,7 +40,7 @@ Zsdd make_power_set(const unordered_set<int>& ids, ZsddManager& mgr) {
     return z;
 }
 
-Zsdd make_zsdd_cnf_clause(const vector<int>& clause, 
+Zsdd make_zsdd_cnf_clause(const FnfFormula::Clause& clause, 
                           unordered_set<int>& all_variables, 
                           ZsddManager& mgr) {
     unordered_set<int> diff = all_variables;
@@ -62,7 +64,7 @@ Zsdd make_zsdd_cnf_clause(const vector<int>& clause,
     return mgr.zsdd_orthogonal_join(clause_set, diff_set);
 }
 
-Zsdd make_zsdd_dnf_term(const vector<int>& term, 
+Zsdd make_zsdd_dnf_term(const FnfFormula::Clause& term, 
                           unordered_set<int>& all_variables, 
                           ZsddManager& mgr) {
     unordered_set<int> diff = all_variables;
@@ -81,14 +83,15 @@ Zsdd make_zsdd_dnf_term(const vector<int>& term,
 }
 
 
-Zsdd compile_dnf(const vector<vector<int>>& dnf, const int num_variables, ZsddManager& mgr) {
+Zsdd compile_dnf(const FnfFormula& dnf, const int num_variables,
+                 const CompileOptions& /*options*/, ZsddManager& mgr) {
     unordered_set<int> all_variables;
     for (int i = 1; i <= num_variables; i++) {
         all_variables.insert(i);
     }
     vector<Zsdd> term_zsdds;
-    for (auto term : dnf) {
-        term_zsdds.push_back(make_zsdd_dnf_term(term, all_variables, mgr));
+    for (size_t i = 0; i < dnf.size(); i++) {
+        term_zsdds.push_back(make_zsdd_dnf_term(dnf[i], all_variables, mgr));
     }
     mgr.gc();
     
@@ -108,97 +111,224 @@ Zsdd compile_dnf(const vector<vector<int>>& dnf, const int num_variables, ZsddMa
     return term_zsdds[0];
 }
 
-Zsdd compile_cnf(const vector<vector<int>>& cnf, const int num_variables, ZsddManager& mgr) {
-    unordered_set<int> all_variables;
-    for (int i = 1; i <= num_variables; i++) {
-        all_variables.insert(i);
-    }
-    vector<Zsdd> clause_zsdds;
-    for (auto& clause : cnf) {
-        clause_zsdds.push_back(make_zsdd_cnf_clause(clause, all_variables, mgr));
-    }
-    while (clause_zsdds.size() > 1) {
+// intersect zsdds pairwise until one is left. a snapshot of the
+// remaining zsdds is written after each round.
+Zsdd reduce_by_intersection(vector<Zsdd>& zsdds, ZsddManager& mgr,
+                            SnapshotWriter* snapshot = nullptr) {
+    while (zsdds.size() > 1) {
         vector<Zsdd> tmp_zsdds;
-        for (int i = 0; i < (int)(clause_zsdds.size() + 1) / 2; i++) {
-            if (2 * i + 1 >= (int)clause_zsdds.size()) {
-                tmp_zsdds.push_back(clause_zsdds[2*i]);
+        for (int i = 0; i < (int)(zsdds.size() + 1) / 2; i++) {
+            if (2 * i + 1 >= (int)zsdds.size()) {
+                tmp_zsdds.push_back(zsdds[2*i]);
             }
             else {
-                tmp_zsdds.push_back(mgr.zsdd_intersection(clause_zsdds[2*i], clause_zsdds[2*i+1]));
+                tmp_zsdds.push_back(mgr.zsdd_intersection(zsdds[2*i], zsdds[2*i+1]));
             }
         }
-        clause_zsdds = tmp_zsdds;
+        zsdds = tmp_zsdds;
         mgr.gc();
+        if (snapshot != nullptr && zsdds.size() > 1) {
+            snapshot->write(mgr, zsdds);
+        }
     }
-    return clause_zsdds[0];
+    return zsdds[0];
 }
 
-vector<vector<int>> read_fnf(const string& file_name, int* num_variables) {
-    // read dimacs form cnf/dnf format
-    vector<vector<int>> fnf;
-    ifstream ifs(file_name);
-    if (ifs.fail()) {
-        cerr << "can't read " << file_name << endl;
-        exit(1);
+Zsdd compile_cnf_on(const FnfFormula& cnf, unordered_set<int>& all_variables, 
+                    ZsddManager& mgr) {
+    if (cnf.empty()) {
+        return make_power_set(all_variables, mgr);
     }
-    string line;
+    vector<Zsdd> clause_zsdds;
+    for (size_t i = 0; i < cnf.size(); i++) {
+        clause_zsdds.push_back(make_zsdd_cnf_clause(cnf[i], all_variables, mgr));
+    }
+    return reduce_by_intersection(clause_zsdds, mgr);
+}
 
-    bool on_reading_header = true;
-    
-    while (getline(ifs, line)) {
-        if (line[0] == 'c') continue;
-        if (on_reading_header) {
-            assert(line[0] == 'p');
-            on_reading_header = false;
-            istringstream is(line);
-            string p;
-            string form;
-            is >> p;
-            is >> form;
-            is >> *num_variables;
-        } 
-        else {
-            istringstream is(line);
-            vector<int> clause;
-            while (!is.eof()) {
-                int e;
-                is >> e;
-                clause.push_back(e);
-            }
-            assert(*(clause.rbegin()) == 0);
-            clause.pop_back();
-            fnf.push_back(move(clause));
+Zsdd compile_cnf(const FnfFormula& cnf, const int num_variables,
+                 const CompileOptions& options, ZsddManager& mgr) {
+    unordered_set<int> all_variables;
+    for (int i = 1; i <= num_variables; i++) {
+        all_variables.insert(i);
+    }
+    const string& file_name = options.checkpoint_file_name;
+    if (file_name == "" || cnf.empty()) {
+        return compile_cnf_on(cnf, all_variables, mgr);
+    }
+    // the clause zsdds are over num_variables variables, so it is mixed in
+    // the fingerprint of the cnf.
+    const uint64_t fingerprint = (cnf.fingerprint() ^ num_variables) * 1099511628211ULL;
+    SnapshotWriter snapshot(file_name, fingerprint);
+    vector<Zsdd> clause_zsdds;
+    if (ifstream(file_name).good()) {
+        clause_zsdds = snapshot.read(mgr);
+        cerr << "resuming from " << file_name << "... zsdds=" << clause_zsdds.size() << endl;
+    } else {
+        for (size_t i = 0; i < cnf.size(); i++) {
+            clause_zsdds.push_back(make_zsdd_cnf_clause(cnf[i], all_variables, mgr));
         }
     }
+    Zsdd z = reduce_by_intersection(clause_zsdds, mgr, &snapshot);
+    snapshot.wait();
+    remove(file_name.c_str());
+    return z;
+}
 
-    return fnf;
+// compile components in separate managers by num_threads threads, and
+// import the products of the components of each thread into mgr.
+Zsdd compile_components_parallel(const vector<CnfComponent>& components,
+                                 const unsigned int num_threads, ZsddManager& mgr) {
+    const size_t n = min<size_t>(num_threads, components.size());
+    vector<unique_ptr<ZsddManager>> managers;
+    for (size_t t = 0; t < n; t++) {
+        managers.emplace_back(new ZsddManager(mgr.vtree(), 1U<<22));
+    }
+    vector<vector<Zsdd>> products(n);
+    atomic<size_t> next(0);
+    auto compile = [&](const size_t t) {
+        ZsddManager& m = *managers[t];
+        Zsdd z = m.make_zsdd_baseset();
+        for (size_t i = next++; i < components.size(); i = next++) {
+            unordered_set<int> comp_variables(components[i].variables.begin(),
+                                              components[i].variables.end());
+            Zsdd comp_zsdd = compile_cnf_on(components[i].clauses, comp_variables, m);
+            z = m.zsdd_orthogonal_join(z, comp_zsdd);
+            m.gc();
+        }
+        products[t].push_back(z);
+    };
+    vector<thread> workers;
+    for (size_t t = 1; t < n; t++) {
+        workers.emplace_back(compile, t);
+    }
+    compile(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    Zsdd z = mgr.make_zsdd_baseset();
+    for (size_t t = 0; t < n; t++) {
+        z = mgr.zsdd_orthogonal_join(z, mgr.import_from(*managers[t], products[t][0]));
+        products[t].clear();
+        managers[t].reset();
+    }
+    return z;
 }
 
+Zsdd compile_preprocessed_cnf(const FnfFormula& cnf, const int /*num_variables*/, 
+                              const CompileOptions& options, ZsddManager& mgr) {
+    PreprocessedCnf pre = preprocess_cnf(cnf);
+    cerr << "preprocessing... fixed=" << pre.fixed_literals.size()
+         << " free=" << pre.free_variables.size()
+         << " components=" << pre.components.size() << endl;
+    if (pre.unsat) {
+        return mgr.make_zsdd_empty();
+    }
+    // components have disjoint variables, so that they are combined by orthogonal joins.
+    Zsdd z = mgr.make_zsdd_baseset();
+    if (options.num_threads > 1 && pre.components.size() > 1) {
+        z = compile_components_parallel(pre.components, options.num_threads, mgr);
+    } else {
+        for (const auto& comp : pre.components) {
+            unordered_set<int> comp_variables(comp.variables.begin(), comp.variables.end());
+            Zsdd comp_zsdd = compile_cnf_on(comp.clauses, comp_variables, mgr);
+            z = mgr.zsdd_orthogonal_join(z, comp_zsdd);
+            mgr.gc();
+        }
+    }
+    for (auto l : pre.fixed_literals) {
+        if (l > 0) {
+            z = mgr.zsdd_orthogonal_join(z, mgr.make_zsdd_literal(l));
+        }
+    }
+    unordered_set<int> free_variables(pre.free_variables.begin(), pre.free_variables.end());
+    return mgr.zsdd_orthogonal_join(z, make_power_set(free_variables, mgr));
+}
 
-vector<vector<int>> read_setset(const string& file_name) {
-    ifstream ifs(file_name);
+// compile the inputs of a manifest on one manager. a line of the manifest
+// is an input cnf/dnf file and an optional output zsdd binary file. the
+// vtree is given or right-linear on the largest number of variables, and
+// a result is the same as the one compiled alone with that vtree.
+// the results are kept until all inputs are compiled, so that their nodes
+// survive the gc of later compilations and are shared by them. the cache
+// is still cleared by each gc, since it may refer to collected nodes.
+void compile_manifest(const string& manifest_file_name, const string& vtree_file_name,
+                      const CompileOptions& options, const bool use_preprocessing,
+                      const bool use_explicit_representation) {
+    ifstream ifs(manifest_file_name);
     if (ifs.fail()) {
-        cerr << "can't read " << file_name << endl;
+        cerr << "can't read " << manifest_file_name << endl;
         exit(1);
     }
+    vector<pair<string, string>> entries;
     string line;
-    vector<vector<int>> setset;
     while (getline(ifs, line)) {
-        setset.push_back(split(line, ' '));
+        istringstream iss(line);
+        string input, output;
+        if (!(iss >> input) || input[0] == '#') continue;
+        iss >> output;
+        entries.emplace_back(input, output);
     }
-    return setset;
-}
+    vector<FnfFormula> formulas(entries.size());
+    vector<string> forms(entries.size());
+    int max_variables = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        formulas[i] = FnfFormula::read_dimacs(entries[i].first, options.num_threads, &forms[i]);
+        max_variables = max(max_variables, formulas[i].num_variables());
+    }
+    cerr << "reading manifest... inputs=" << entries.size() << " vars=" << max_variables << endl;
 
+    VTree vtree = (vtree_file_name != "") ?
+        VTree::import_from_sdd_vtree_file(vtree_file_name) :
+        VTree::construct_right_linear_vtree(max_variables);
+    ZsddManager mgr(vtree, 1U<<24);
+    vector<Zsdd> results;
+    results.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        auto compiler = compile_dnf;
+        if (forms[i] == "cnf") {
+            compiler = use_preprocessing ? compile_preprocessed_cnf : compile_cnf;
+        }
+        auto compile_start = chrono::system_clock::now();
+        Zsdd zsdd = compiler(formulas[i], formulas[i].num_variables(), options, mgr);
+        if (use_explicit_representation) {
+            zsdd = mgr.zsdd_to_explicit_form(zsdd);
+        }
+        auto compile_end = chrono::system_clock::now();
+        formulas[i] = FnfFormula();
+        if (entries[i].second != "") {
+            mgr.save(zsdd, entries[i].second);
+        }
+        cout << entries[i].first << "\t" << zsdd.size() << "\t" << zsdd.count_solution_exact() << "\t"
+             << chrono::duration_cast<chrono::milliseconds>(compile_end - compile_start).count()
+             << endl;
+        results.push_back(zsdd);
+    }
+}
 
 void show_help_and_exit() {
     cout << "zsdd: Zero-suppressed Sentential Decision Diagrams\n"
-         << "zsdd [-c .] [-d .] [-v .] [-R .] [-S .]  [-h]\n"
+         << "zsdd [-c .] [-d .] [-s .] [-m .] [-r .] [-b .] [-z .] [-v .] [-e] [-p] [-j .] [-C .] [-R .] [-B .] [-Z .] [-S .] [-l .]  [-h]\n"
          << "    -c FILE        set input CNF file\n"
          << "    -d FILE        set input DNF file\n"
+         << "    -s FILE        set input set family file (a set of variables per line)\n"
+         << "    -m FILE        compile the CNF/DNF files of a manifest on one manager\n"
+         << "                   (a line is an input file and an optional output ZSDD binary file;\n"
+         << "                   results are kept in memory, so that later inputs share their nodes)\n"
+         << "    -r FILE        set input ZSDD file (instead of -c/-d, requires -v)\n"
+         << "    -b FILE        set input ZSDD binary file (instead of -c/-d)\n"
+         << "    -z FILE        set input frozen ZSDD file to serve with -l (instead of -c/-d)\n"
          << "    -v FILE        set input VTREE file (default is a right-linear vtree)\n"
-         << "    -e             use zsdd without implicit partitioning"
+         << "    -e             use zsdd without implicit partitioning\n"
+         << "    -p             preprocess CNF (unit propagation, subsumption, components)\n"
+         << "    -j N           set number of threads (default is 1)\n"
+         << "    -C FILE        write snapshots of CNF compilation to FILE, and resume from it if it exists\n"
+         << "                   (a snapshot written for another input is refused)\n"
          << "    -R FILE        set output ZSDD file\n"
+         << "    -B FILE        set output ZSDD binary file\n"
+         << "    -Z FILE        set output frozen ZSDD file (read-only query format)\n"
          << "    -S FILE        set output ZSDD (dot) file\n"
+         << "    -l FILE        serve queries on a Unix domain socket FILE by N (-j) threads\n"
          << "    -h             show help message and exit\n";
     exit(1);
 }
@@ -211,10 +341,21 @@ int main(int argc, char** argv)
     string vtree_file_name = "";
     string cnf_input_file_name = "";
     string dnf_input_file_name = "";
+    string set_input_file_name = "";
     string txt_output_file_name = "";
     string dot_output_file_name = "";
+    string binary_input_file_name = "";
+    string txt_input_file_name = "";
+    string binary_output_file_name = "";
+    string frozen_output_file_name = "";
+    string checkpoint_file_name = "";
+    string manifest_file_name = "";
+    string socket_file_name = "";
+    string frozen_input_file_name = "";
     bool use_explicit_representation = false;
-    while ((opt = getopt(argc, argv, "v:c:d:e:R:S:h")) != -1) {
+    bool use_preprocessing = false;
+    unsigned int num_threads = 1;
+    while ((opt = getopt(argc, argv, "v:c:d:s:m:b:r:z:epj:C:R:B:Z:S:l:h")) != -1) {
         switch (opt) {
         case 'v':
             vtree_file_name = optarg;
@@ -225,62 +366,155 @@ int main(int argc, char** argv)
         case 'd':
             dnf_input_file_name = optarg;
             break;
+        case 's':
+            set_input_file_name = optarg;
+            break;
+        case 'm':
+            manifest_file_name = optarg;
+            break;
         case 'e':
             use_explicit_representation = true;
             break;
+        case 'p':
+            use_preprocessing = true;
+            break;
+        case 'j':
+            num_threads = stoi(optarg);
+            break;
+        case 'C':
+            checkpoint_file_name = optarg;
+            break;
+        case 'b':
+            binary_input_file_name = optarg;
+            break;
+        case 'r':
+            txt_input_file_name = optarg;
+            break;
         case 'R':
             txt_output_file_name = optarg;
             break;
+        case 'B':
+            binary_output_file_name = optarg;
+            break;
+        case 'Z':
+            frozen_output_file_name = optarg;
+            break;
         case 'S':
             dot_output_file_name = optarg;
             break;
+        case 'l':
+            socket_file_name = optarg;
+            break;
+        case 'z':
+            frozen_input_file_name = optarg;
+            break;
         case 'h':
             show_help_and_exit();
             break;
         }
     }
-    if (cnf_input_file_name == "" && dnf_input_file_name == "") {
+    if (manifest_file_name != "") {
+        if (checkpoint_file_name != "") {
+            cerr << "[error] -C can't be used with -m" << endl;
+            exit(1);
+        }
+        compile_manifest(manifest_file_name, vtree_file_name, CompileOptions{num_threads, ""},
+                         use_preprocessing, use_explicit_representation);
+        return 0;
+    }
+    if (frozen_input_file_name != "") {
+        // a frozen file is only served, so that it isn't loaded into a manager.
+        if (socket_file_name == "") {
+            cerr << "[error] -z requires a socket file (-l)" << endl;
+            exit(1);
+        }
+        cerr << "loading zsdd (frozen)..." << endl;
+        const FrozenZsdd frozen(frozen_input_file_name);
+        ZsddServer server(frozen);
+        server.serve(socket_file_name, num_threads);
+        return 0;
+    }
+    if (cnf_input_file_name == "" && dnf_input_file_name == "" && set_input_file_name == "" &&
+        binary_input_file_name == "" && txt_input_file_name == "") {
         show_help_and_exit();
     }
+    if (checkpoint_file_name != "" && (cnf_input_file_name == "" || use_preprocessing)) {
+        cerr << "[error] -C requires a CNF file (-c) without -p" << endl;
+        exit(1);
+    }
+    if (txt_input_file_name != "" && vtree_file_name == "") {
+        cerr << "[error] -r requires the vtree of the zsdd file (-v)" << endl;
+        exit(1);
+    }
+    const bool load_zsdd = (binary_input_file_name != "" || txt_input_file_name != "");
 
     VTree* vtree = nullptr;
 
     auto compiler = compile_dnf;
     if (cnf_input_file_name != "") {
-        compiler = compile_cnf;
+        compiler = use_preprocessing ? compile_preprocessed_cnf : compile_cnf;
     }
-    vector<vector<int>> fnf;
-    int num_variables;
+    FnfFormula fnf;
     if (cnf_input_file_name != "") {
-        fnf = read_fnf(cnf_input_file_name, &num_variables);
-        cerr << "reading cnf... vars=" << num_variables << " clauses=" << fnf.size() << endl;
-    } else {
-        fnf = read_fnf(dnf_input_file_name, &num_variables);
-        cerr << "reading dnf... vars=" << num_variables << " terms=" << fnf.size() << endl;
+        fnf = FnfFormula::read_dimacs(cnf_input_file_name, num_threads);
+        cerr << "reading cnf... vars=" << fnf.num_variables() << " clauses=" << fnf.size() << endl;
+    } else if (dnf_input_file_name != "") {
+        fnf = FnfFormula::read_dimacs(dnf_input_file_name, num_threads);
+        cerr << "reading dnf... vars=" << fnf.num_variables() << " terms=" << fnf.size() << endl;
     }
+    vector<int> set_variables;
+    vector<size_t> set_offsets;
+    if (set_input_file_name != "") {
+        fnf.set_num_variables(read_setfamily(set_input_file_name, set_variables, set_offsets));
+        cerr << "reading set family... vars=" << fnf.num_variables()
+             << " sets=" << set_offsets.size() - 1 << endl;
+    }
+    const int num_variables = fnf.num_variables();
 
     if (vtree_file_name != "") {
         vtree = new VTree(VTree::import_from_sdd_vtree_file(vtree_file_name));
         cerr << "loading vtree..." << endl;
+    } else if (binary_input_file_name != "") {
+        vtree = new VTree(ZsddManager::load_vtree(binary_input_file_name));
+        cerr << "loading vtree (from zsdd binary)..." << endl;
     } else {
         vtree = new VTree( VTree::construct_right_linear_vtree(num_variables));
         cerr << "creating vtree (right-linear)..." << endl;
     }
     ZsddManager mgr(*vtree,  1U<<24);
 
-    cerr << "compiling..." << endl;
     auto compile_start = chrono::system_clock::now();
-    Zsdd zsdd = compiler(fnf, num_variables, mgr);
+    Zsdd zsdd = mgr.make_zsdd_empty();
+    if (binary_input_file_name != "") {
+        cerr << "loading zsdd..." << endl;
+        zsdd = mgr.load(binary_input_file_name);
+    } else if (txt_input_file_name != "") {
+        cerr << "loading zsdd..." << endl;
+        ifstream ifs(txt_input_file_name);
+        if (ifs.fail()) {
+            cerr << "can't read " << txt_input_file_name << endl;
+            exit(1);
+        }
+        zsdd = mgr.import_zsdd_txt(ifs);
+    } else if (set_input_file_name != "") {
+        cerr << "compiling..." << endl;
+        zsdd = mgr.make_zsdd_from_sets(set_variables, set_offsets);
+        vector<int>().swap(set_variables);
+        vector<size_t>().swap(set_offsets);
+    } else {
+        cerr << "compiling..." << endl;
+        zsdd = compiler(fnf, num_variables, CompileOptions{num_threads, checkpoint_file_name}, mgr);
+    }
     if (use_explicit_representation) {
         zsdd = mgr.zsdd_to_explicit_form(zsdd);
     }
     auto compile_end = chrono::system_clock::now();
-    cerr << "compilation time: "
+    cerr << (load_zsdd ? "loading time: " : "compilation time: ")
          << chrono::duration_cast<chrono::milliseconds>(compile_end - compile_start).count() 
          << " msec" << endl;
 
     cerr << "zsdd node count: " << zsdd.size() << endl;
-    cerr << "zsdd model count: " << zsdd.count_solution() << endl;
+    cerr << "zsdd model count: " << zsdd.count_solution_exact() << endl;
 
     if (txt_output_file_name != "") {
         cerr << "output zsdd..." << endl;
@@ -289,12 +523,28 @@ int main(int argc, char** argv)
         ofs.close();
     }
 
+    if (binary_output_file_name != "") {
+        cerr << "output zsdd (binary)..." << endl;
+        mgr.save(zsdd, binary_output_file_name);
+    }
+
+    if (frozen_output_file_name != "") {
+        cerr << "output zsdd (frozen)..." << endl;
+        FrozenZsdd::write(mgr, {zsdd}, frozen_output_file_name);
+    }
+
     if (dot_output_file_name != "") {
         cerr << "output zsdd (dot)..." << endl;
         ofstream ofs(dot_output_file_name);
         zsdd.export_dot(ofs);
         ofs.close();
     }
+
+    if (socket_file_name != "") {
+        const shared_ptr<const FrozenZsdd> frozen = mgr.freeze({zsdd});
+        ZsddServer server(*frozen);
+        server.serve(socket_file_name, num_threads);
+    }
     
     return 0;
 }
@@ -33,6 +33,23 @@ public:
     unsigned long long int count_solution() const {
         return mngr_.count_solution(addr_);
     }
+    std::string count_solution_exact() const {
+        return mngr_.count_solution_exact(addr_);
+    }
+    double count_solution_log2() const {
+        return mngr_.count_solution_log2(addr_);
+    }
+    std::vector<unsigned long long> count_by_size() const {
+        return mngr_.count_by_size(addr_);
+    }
+    std::vector<double> weighted_count(const std::vector<double>& weights,
+                                       const size_t batch_size = 1) const {
+        return mngr_.weighted_count(addr_, weights, batch_size);
+    }
+
+    bool is_member(const std::vector<int>& set) const {
+        return mngr_.is_member(addr_, set);
+    }
 
     unsigned long long int size() const {
         return mngr_.size(addr_);
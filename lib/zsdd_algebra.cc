@@ -0,0 +1,220 @@
+#include "zsdd_manager.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include "zsdd.h"
+
+namespace zsdd {
+
+Zsdd ZsddManager::zsdd_join(const Zsdd& lhs, const Zsdd& rhs) {
+    addr_t res = zsdd_algebra_apply(Operation::JOIN, lhs.addr(), rhs.addr());
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_meet(const Zsdd& lhs, const Zsdd& rhs) {
+    addr_t res = zsdd_algebra_apply(Operation::MEET, lhs.addr(), rhs.addr());
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_restrict(const Zsdd& lhs, const Zsdd& rhs) {
+    addr_t res = zsdd_algebra_apply(Operation::RESTRICT, lhs.addr(), rhs.addr());
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_permit(const Zsdd& lhs, const Zsdd& rhs) {
+    addr_t res = zsdd_algebra_apply(Operation::PERMIT, lhs.addr(), rhs.addr());
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_nonsuperset(const Zsdd& lhs, const Zsdd& rhs) {
+    addr_t res = zsdd_algebra_apply(Operation::NONSUPERSET, lhs.addr(), rhs.addr());
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_minimal(const Zsdd& z) {
+    addr_t res = zsdd_extremal_inner(Operation::MINIMAL, z.addr());
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_maximal(const Zsdd& z) {
+    addr_t res = zsdd_extremal_inner(Operation::MAXIMAL, z.addr());
+    return Zsdd(res, *this);
+}
+
+
+// operations whose result on an element pair is the product of the
+// results on the primes and the subs. unlike zsdd_apply, the primes of
+// the results may overlap, so that the products are united.
+addr_t ZsddManager::zsdd_algebra_apply(const Operation& op, const addr_t lhs, const addr_t rhs) {
+    if (op == Operation::JOIN || op == Operation::MEET) {
+        if (lhs > rhs) return zsdd_algebra_apply(op, rhs, lhs);
+    }
+    if (lhs == ZSDD_NULL || rhs == ZSDD_NULL) return ZSDD_NULL;
+    // check trivial case
+    if (op == Operation::JOIN) {
+        if (lhs == ZSDD_FALSE || rhs == ZSDD_FALSE) return ZSDD_FALSE;
+        if (lhs == ZSDD_EMPTY) return rhs;
+    }
+    else if (op == Operation::MEET) {
+        if (lhs == ZSDD_FALSE || rhs == ZSDD_FALSE) return ZSDD_FALSE;
+        if (lhs == ZSDD_EMPTY) return ZSDD_EMPTY;
+        if (lhs == rhs && get_zsddnode_at(lhs).type() == NodeType::LIT) return lhs;
+    }
+    else if (op == Operation::RESTRICT) {
+        if (lhs == ZSDD_FALSE || rhs == ZSDD_FALSE) return ZSDD_FALSE;
+        if (lhs == rhs) return lhs;
+        // every set is a superset of {}.
+        if (intersects_inner(ZSDD_EMPTY, rhs)) return lhs;
+        if (lhs == ZSDD_EMPTY) return ZSDD_FALSE;
+    }
+    else if (op == Operation::PERMIT) {
+        if (lhs == ZSDD_FALSE || rhs == ZSDD_FALSE) return ZSDD_FALSE;
+        if (lhs == rhs || lhs == ZSDD_EMPTY) return lhs;
+        if (rhs == ZSDD_EMPTY) return intersects_inner(ZSDD_EMPTY, lhs) ? ZSDD_EMPTY : ZSDD_FALSE;
+    }
+    else if (op == Operation::NONSUPERSET) {
+        if (lhs == ZSDD_FALSE || rhs == ZSDD_FALSE) return lhs;
+        if (lhs == rhs || intersects_inner(ZSDD_EMPTY, rhs)) return ZSDD_FALSE;
+        if (lhs == ZSDD_EMPTY) return lhs;
+    }
+    else {
+        std::cerr << "[error] unsupported operation on zsdd_algebra_apply" << std::endl;
+        exit(1);
+    }
+    // literals of the same variable.
+    if (lhs >= 0 && rhs >= 0 && op != Operation::NONSUPERSET) {
+        const ZsddNode& l_node = get_zsddnode_at(lhs);
+        const ZsddNode& r_node = get_zsddnode_at(rhs);
+        if (l_node.type() == NodeType::LIT && r_node.type() == NodeType::LIT &&
+            llabs(l_node.literal()) == llabs(r_node.literal())) {
+            if (op == Operation::JOIN) {
+                return l_node.literal() < 0 ? rhs : lhs;
+            } else if (op == Operation::MEET) {
+                return l_node.literal() < 0 ? lhs : rhs;
+            } else if (op == Operation::RESTRICT) {
+                // rhs is {v}, since rhs doesn't have {}.
+                return rhs;
+            } else {
+                return lhs;
+            }
+        }
+    }
+
+    // cache check
+    {
+        addr_t cache = cache_table_.read_cache(op, lhs, rhs);
+        if (cache != ZSDD_NULL) {
+            return cache;
+        }
+    }
+
+    addr_t res = ZSDD_FALSE;
+    if (op == Operation::NONSUPERSET) {
+        res = zsdd_apply(Operation::DIFFERENCE, lhs,
+                         zsdd_algebra_apply(Operation::RESTRICT, lhs, rhs));
+        cache_table_.write_cache(op, lhs, rhs, res);
+        return res;
+    }
+
+    std::vector<ZsddElement> decomp_l;
+    std::vector<ZsddElement> decomp_r;
+    align_decompositions(lhs, rhs, decomp_l, decomp_r);
+    // products with the same prime are merged first, which is cheaper
+    // than uniting them.
+    std::unordered_map<addr_t, addr_t> subs_of_prime;
+    std::vector<addr_t> primes;
+    for (const auto& l_elem : decomp_l) {
+        for (const auto& r_elem : decomp_r) {
+            addr_t new_p = zsdd_algebra_apply(op, l_elem.first, r_elem.first);
+            if (new_p == ZSDD_NULL || new_p == ZSDD_FALSE) continue;
+            addr_t new_s = zsdd_algebra_apply(op, l_elem.second, r_elem.second);
+            if (new_s == ZSDD_NULL || new_s == ZSDD_FALSE) continue;
+            auto it = subs_of_prime.find(new_p);
+            if (it == subs_of_prime.end()) {
+                subs_of_prime.emplace(new_p, new_s);
+                primes.push_back(new_p);
+            } else {
+                it->second = zsdd_apply(Operation::UNION, it->second, new_s);
+            }
+        }
+    }
+    for (auto p : primes) {
+        addr_t product = zsdd_apply(Operation::ORTHOGONAL_JOIN, p, subs_of_prime.at(p));
+        res = zsdd_apply(Operation::UNION, res, product);
+    }
+    cache_table_.write_cache(op, lhs, rhs, res);
+    return res;
+}
+
+
+// a member (x, y) of an element (p, s) is minimal iff y is minimal in s and
+// no element (p', s') has x' < x in p' and y' <= y in s'. that is, x is in
+// restrict(p, p') \ minimal(p') and y is in restrict(s, s'). maximal is dual
+// with permit.
+addr_t ZsddManager::zsdd_extremal_inner(const Operation& op, const addr_t zsdd) {
+    if (op != Operation::MINIMAL && op != Operation::MAXIMAL) {
+        std::cerr << "[error] unsupported operation on zsdd_extremal_inner" << std::endl;
+        exit(1);
+    }
+    if (zsdd < 0) return zsdd;
+    if (op == Operation::MINIMAL && intersects_inner(ZSDD_EMPTY, zsdd)) {
+        return ZSDD_EMPTY;
+    }
+    // copy the node, since new nodes may reallocate the node table.
+    const ZsddNode n = get_zsddnode_at(zsdd);
+    if (n.type() == NodeType::LIT) {
+        // {v}, or {v} of {{}, {v}} for maximal.
+        return n.literal() > 0 ? zsdd : make_zsdd_literal_inner(-n.literal());
+    }
+
+    {
+        addr_t c = cache_table_.read_cache(op, zsdd, zsdd);
+        if (c != ZSDD_NULL) {
+            return c;
+        }
+    }
+
+    const Operation cover = (op == Operation::MINIMAL) ? Operation::RESTRICT : Operation::PERMIT;
+    const auto& decomp = n.decomposition();
+    std::vector<std::pair<addr_t, addr_t>> candidates;
+    addr_t dominated = ZSDD_FALSE;
+    for (const auto& e : decomp) {
+        if (e.first == ZSDD_FALSE || e.second == ZSDD_FALSE) continue;
+        candidates.emplace_back(e.first, zsdd_extremal_inner(op, e.second));
+        for (const auto& f : decomp) {
+            if (f.first == ZSDD_FALSE || f.second == ZSDD_FALSE) continue;
+            addr_t new_p = zsdd_algebra_apply(cover, e.first, f.first);
+            new_p = zsdd_apply(Operation::DIFFERENCE, new_p, zsdd_extremal_inner(op, f.first));
+            if (new_p == ZSDD_FALSE) continue;
+            addr_t new_s = zsdd_algebra_apply(cover, e.second, f.second);
+            if (new_s == ZSDD_FALSE) continue;
+            dominated = zsdd_apply(Operation::UNION, dominated,
+                                   zsdd_apply(Operation::ORTHOGONAL_JOIN, new_p, new_s));
+        }
+    }
+    assert(!candidates.empty());
+    std::vector<ZsddElement> new_decomposition = compress_candidates(candidates);
+
+    // zero suppression
+    addr_t res;
+    if (new_decomposition.size() == 1 && new_decomposition[0].first == ZSDD_EMPTY) {
+        res = new_decomposition[0].second;
+    } else if (new_decomposition.size() == 1 && new_decomposition[0].second == ZSDD_EMPTY) {
+        res = new_decomposition[0].first;
+    } else {
+        res = make_zsdd_decomposition(std::move(new_decomposition), n.vtree_node_id());
+    }
+    res = zsdd_apply(Operation::DIFFERENCE, res, dominated);
+    cache_table_.write_cache(op, zsdd, zsdd, res);
+    return res;
+}
+
+} // namespace zsdd
@@ -0,0 +1,106 @@
+#include "zsdd_bigint.h"
+#include <math.h>
+#include <algorithm>
+
+namespace zsdd {
+
+BigInt::BigInt(uint64_t value) : limbs_() {
+    while (value != 0) {
+        limbs_.push_back(static_cast<uint32_t>(value));
+        value >>= 32;
+    }
+}
+
+
+size_t BigInt::bit_length() const {
+    if (limbs_.empty()) return 0;
+    size_t n = 32 * (limbs_.size() - 1);
+    for (uint32_t top = limbs_.back(); top != 0; top >>= 1) n++;
+    return n;
+}
+
+
+double BigInt::log2() const {
+    if (limbs_.empty()) return -INFINITY;
+    // the top 64 bits are enough for a double.
+    const size_t n = limbs_.size();
+    double top = limbs_[n-1];
+    if (n >= 2) top = top * 4294967296.0 + limbs_[n-2];
+    const size_t shift = n >= 2 ? 32 * (n - 2) : 0;
+    return ::log2(top) + shift;
+}
+
+
+std::string BigInt::to_string() const {
+    if (limbs_.empty()) return "0";
+    // repeated division by 10^9.
+    std::vector<uint32_t> q(limbs_);
+    std::vector<uint32_t> chunks;
+    while (!q.empty()) {
+        uint64_t r = 0;
+        for (size_t i = q.size(); i-- > 0;) {
+            const uint64_t cur = (r << 32) | q[i];
+            q[i] = static_cast<uint32_t>(cur / 1000000000U);
+            r = cur % 1000000000U;
+        }
+        chunks.push_back(static_cast<uint32_t>(r));
+        while (!q.empty() && q.back() == 0) q.pop_back();
+    }
+    std::string res = std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        const std::string s = std::to_string(chunks[i]);
+        res.append(9 - s.size(), '0');
+        res += s;
+    }
+    return res;
+}
+
+
+BigInt& BigInt::operator+=(const BigInt& rhs) {
+    if (limbs_.size() < rhs.limbs_.size()) limbs_.resize(rhs.limbs_.size(), 0);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < limbs_.size() && (carry != 0 || i < rhs.limbs_.size()); i++) {
+        const uint64_t t = carry + limbs_[i] + (i < rhs.limbs_.size() ? rhs.limbs_[i] : 0);
+        limbs_[i] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+    }
+    if (carry != 0) limbs_.push_back(static_cast<uint32_t>(carry));
+    return *this;
+}
+
+
+void BigInt::add_product(const BigInt& lhs, const BigInt& rhs) {
+    if (lhs.is_zero() || rhs.is_zero()) return;
+    if (&lhs == this || &rhs == this) {
+        const BigInt copy(*this);
+        add_product(&lhs == this ? copy : lhs, &rhs == this ? copy : rhs);
+        return;
+    }
+    const std::vector<uint32_t>& a = lhs.limbs_;
+    const std::vector<uint32_t>& b = rhs.limbs_;
+    if (limbs_.size() < a.size() + b.size()) limbs_.resize(a.size() + b.size(), 0);
+    for (size_t i = 0; i < a.size(); i++) {
+        // (2^32-1)^2 + 2 * (2^32-1) fits in 64 bits.
+        uint64_t carry = 0;
+        const uint64_t ai = a[i];
+        for (size_t j = 0; j < b.size(); j++) {
+            const uint64_t t = ai * b[j] + limbs_[i+j] + carry;
+            limbs_[i+j] = static_cast<uint32_t>(t);
+            carry = t >> 32;
+        }
+        for (size_t k = i + b.size(); carry != 0; k++) {
+            if (k == limbs_.size()) limbs_.push_back(0);
+            const uint64_t t = carry + limbs_[k];
+            limbs_[k] = static_cast<uint32_t>(t);
+            carry = t >> 32;
+        }
+    }
+    trim();
+}
+
+
+void BigInt::trim() {
+    while (!limbs_.empty() && limbs_.back() == 0) limbs_.pop_back();
+}
+
+} // namespace zsdd
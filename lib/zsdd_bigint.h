@@ -0,0 +1,41 @@
+#ifndef ZSDD_BIGINT_H_
+#define ZSDD_BIGINT_H_
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace zsdd {
+
+// non-negative multi-precision integer for model counts.
+// limbs are 32 bits, so that a limb product fits in 64 bits.
+class BigInt {
+public:
+    BigInt() : limbs_() {}
+    explicit BigInt(uint64_t value);
+
+    bool is_zero() const { return limbs_.empty(); }
+    size_t bit_length() const;
+    double log2() const;
+    std::string to_string() const;
+
+    BigInt& operator+=(const BigInt& rhs);
+    // *this += lhs * rhs without a temporary product.
+    void add_product(const BigInt& lhs, const BigInt& rhs);
+
+    bool operator==(const BigInt& rhs) const { return limbs_ == rhs.limbs_; }
+    bool operator!=(const BigInt& rhs) const { return limbs_ != rhs.limbs_; }
+
+    friend std::ostream& operator<<(std::ostream& os, const BigInt& n) {
+        return os << n.to_string();
+    }
+
+private:
+    std::vector<uint32_t> limbs_; // little endian, without leading zero limbs
+
+    void trim();
+};
+
+} // namespace zsdd
+
+#endif // ZSDD_BIGINT_H_
@@ -0,0 +1,182 @@
+#include "zsdd_manager.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <algorithm>
+#include <iostream>
+#include "zsdd.h"
+#include "zsdd_count.h"
+
+namespace zsdd {
+
+namespace {
+
+// an upper bound of the sizes of the members of zsdd:
+// the number of variables of its vtree node.
+int max_member_size(const ZsddManager& mgr, const addr_t zsdd) {
+    if (zsdd < 0) return 0;
+    const int v = mgr.get_zsddnode_at(zsdd).vtree_node_id();
+    return mgr.vtree().leaf_end(v) - mgr.vtree().leaf_begin(v);
+}
+
+} // namespace
+
+
+std::vector<unsigned long long> ZsddManager::count_by_size(const addr_t zsdd) const {
+    std::vector<unsigned long long> counts;
+    if (!count_models_by_size(*this, zsdd, counts)) {
+        std::cerr << "[error] model count overflows 64 bits (use count_by_size_exact)" << std::endl;
+        exit(1);
+    }
+    return counts;
+}
+
+
+std::vector<std::string> ZsddManager::count_by_size_exact(const addr_t zsdd) const {
+    std::vector<std::string> res;
+    const size_t num_variables = (vtree_.size() + 1) / 2;
+    switch (exact_count_type(num_variables)) {
+    case CountType::UINT64: {
+        std::vector<unsigned long long> counts;
+        count_models_by_size(*this, zsdd, counts);
+        for (const auto& c : counts) res.push_back(CountTraits<unsigned long long>::to_string(c));
+        break;
+    }
+#ifdef ZSDD_HAS_INT128
+    case CountType::UINT128: {
+        std::vector<uint128_t> counts;
+        count_models_by_size(*this, zsdd, counts);
+        for (const auto& c : counts) res.push_back(CountTraits<uint128_t>::to_string(c));
+        break;
+    }
+#endif
+    default: {
+        std::vector<BigInt> counts;
+        count_models_by_size(*this, zsdd, counts);
+        for (const auto& c : counts) res.push_back(c.to_string());
+        break;
+    }
+    }
+    return res;
+}
+
+
+Zsdd ZsddManager::zsdd_filter_size_eq(const Zsdd& z, const int k) {
+    addr_t res = zsdd_filter_size_inner(Operation::FILTER_SIZE_EQ, z.addr(), k);
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_filter_size_le(const Zsdd& z, const int k) {
+    addr_t res = zsdd_filter_size_inner(Operation::FILTER_SIZE_LE, z.addr(), k);
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_filter_size_ge(const Zsdd& z, const int k) {
+    addr_t res = zsdd_filter_size_inner(Operation::FILTER_SIZE_GE, z.addr(), k);
+    return Zsdd(res, *this);
+}
+
+
+addr_t ZsddManager::zsdd_filter_size_inner(const Operation& op, const addr_t zsdd, const int k) {
+    if (op != Operation::FILTER_SIZE_EQ &&
+        op != Operation::FILTER_SIZE_LE &&
+        op != Operation::FILTER_SIZE_GE) {
+        std::cerr << "[error] unsupported operation on zsdd_filter_size_inner" << std::endl;
+        exit(1);
+    }
+    if (zsdd == ZSDD_FALSE || zsdd == ZSDD_NULL) {
+        return zsdd;
+    }
+
+    // members have sizes in [0, max_size], so that k out of the range
+    // keeps all or nothing.
+    const int max_size = max_member_size(*this, zsdd);
+    if (op == Operation::FILTER_SIZE_EQ) {
+        if (k < 0 || k > max_size) return ZSDD_FALSE;
+    } else if (op == Operation::FILTER_SIZE_LE) {
+        if (k < 0) return ZSDD_FALSE;
+        if (k >= max_size) return zsdd;
+    } else {
+        if (k <= 0) return zsdd;
+        if (k > max_size) return ZSDD_FALSE;
+    }
+    if (zsdd == ZSDD_EMPTY) {
+        return zsdd;
+    }
+
+    const ZsddNode n = get_zsddnode_at(zsdd);
+    if (n.type() == NodeType::LIT) {
+        // k is 0 or 1 here. {v} has size 1, and {{}, {v}} keeps {} for
+        // k = 0 and {v} for k = 1.
+        if (n.literal() > 0) {
+            return k == 1 ? zsdd : ZSDD_FALSE;
+        }
+        return k == 0 ? ZSDD_EMPTY : make_zsdd_literal_inner(-n.literal());
+    }
+
+    {
+        addr_t cache = cache_table_.read_cache(op, zsdd, k);
+        if (cache != ZSDD_NULL) {
+            return cache;
+        }
+    }
+
+    // a member of size k of an element (p, s) is a member of size i of p
+    // and a member of size k - i of s. primes of different sizes are
+    // disjoint, so that the candidates have disjoint primes.
+    std::vector<std::pair<addr_t, addr_t>> candidates;
+    auto add_candidate = [&candidates](const addr_t p, const addr_t s) {
+        if (p == ZSDD_FALSE || s == ZSDD_FALSE) return;
+        candidates.emplace_back(p, s);
+    };
+    const auto& decomp = n.decomposition();
+    assert(!decomp.empty());
+    for (const auto& e : decomp) {
+        const int prime_max = max_member_size(*this, e.first);
+        const int sub_max = max_member_size(*this, e.second);
+        if (op == Operation::FILTER_SIZE_EQ) {
+            for (int i = std::max(0, k - sub_max); i <= std::min(k, prime_max); i++) {
+                add_candidate(zsdd_filter_size_inner(Operation::FILTER_SIZE_EQ, e.first, i),
+                              zsdd_filter_size_inner(Operation::FILTER_SIZE_EQ, e.second, k - i));
+            }
+        } else if (op == Operation::FILTER_SIZE_LE) {
+            for (int i = 0; i <= std::min(k, prime_max); i++) {
+                add_candidate(zsdd_filter_size_inner(Operation::FILTER_SIZE_EQ, e.first, i),
+                              zsdd_filter_size_inner(Operation::FILTER_SIZE_LE, e.second, k - i));
+            }
+        } else {
+            // primes of size less than k, and the primes of size k or more
+            // with the whole sub.
+            for (int i = std::max(0, k - sub_max); i < std::min(k, prime_max + 1); i++) {
+                add_candidate(zsdd_filter_size_inner(Operation::FILTER_SIZE_EQ, e.first, i),
+                              zsdd_filter_size_inner(Operation::FILTER_SIZE_GE, e.second, k - i));
+            }
+            add_candidate(zsdd_filter_size_inner(Operation::FILTER_SIZE_GE, e.first, k), e.second);
+        }
+    }
+    if (candidates.empty()) {
+        cache_table_.write_cache(op, zsdd, k, ZSDD_FALSE);
+        return ZSDD_FALSE;
+    }
+    std::vector<ZsddElement> new_decomposition = compress_candidates(candidates);
+
+    // zero suppression
+    if (new_decomposition.size() == 1) {
+        ZsddElement& e = new_decomposition[0];
+        if (e.first == ZSDD_EMPTY) {
+            cache_table_.write_cache(op, zsdd, k, e.second);
+            return e.second;
+        }
+        if (e.second == ZSDD_EMPTY) {
+            cache_table_.write_cache(op, zsdd, k, e.first);
+            return e.first;
+        }
+    }
+
+    addr_t new_res = make_zsdd_decomposition(std::move(new_decomposition), n.vtree_node_id());
+    cache_table_.write_cache(op, zsdd, k, new_res);
+    return new_res;
+}
+
+} // namespace zsdd
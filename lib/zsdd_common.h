@@ -25,6 +25,21 @@ enum  class Operation : char
     FILTER_CONTAIN,
     POWER_SET,
     EXPLICIT_FORM,
+    FILTER_SIZE_EQ,
+    FILTER_SIZE_LE,
+    FILTER_SIZE_GE,
+    EXISTS,
+    INTERSECTS,
+    SUBSET,
+    COVERED,
+    JOIN,
+    MEET,
+    RESTRICT,
+    PERMIT,
+    NONSUPERSET,
+    MINIMAL,
+    MAXIMAL,
+    CONDITION,
 };
 
 
@@ -0,0 +1,114 @@
+#include "zsdd_compiler.h"
+#include <stdlib.h>
+#include <iostream>
+
+namespace zsdd {
+
+ZsddCompiler::ZsddCompiler(ZsddManager& mgr, const Form form)
+    : mgr_(mgr),
+      form_(form),
+      universe_(mgr.make_zsdd_powerset(mgr.vtree().root())),
+      root_(form == Form::CNF ? universe_ : mgr.make_zsdd_empty()),
+      checkpoints_()
+{}
+
+
+ZsddCompiler::ZsddCompiler(ZsddManager& mgr, const Form form, const Zsdd& root)
+    : mgr_(mgr),
+      form_(form),
+      universe_(mgr.make_zsdd_powerset(mgr.vtree().root())),
+      root_(root),
+      checkpoints_()
+{}
+
+
+const Zsdd& ZsddCompiler::add(const FnfFormula& batch) {
+    std::vector<Zsdd> parts;
+    parts.reserve(batch.size());
+    const Zsdd& base = (form_ == Form::CNF) ? root_ : universe_;
+    for (size_t i = 0; i < batch.size(); i++) {
+        const FnfFormula::Clause c = batch[i];
+        parts.push_back(filter_by_literals(base, c.begin(), c.end()));
+    }
+    apply_parts(parts);
+    return root_;
+}
+
+
+const Zsdd& ZsddCompiler::add(const std::vector<int>& literals) {
+    std::vector<Zsdd> parts;
+    const Zsdd& base = (form_ == Form::CNF) ? root_ : universe_;
+    parts.push_back(filter_by_literals(base, literals.data(), literals.data() + literals.size()));
+    apply_parts(parts);
+    return root_;
+}
+
+
+size_t ZsddCompiler::checkpoint() {
+    checkpoints_.push_back(root_);
+    return checkpoints_.size();
+}
+
+
+void ZsddCompiler::rollback() {
+    if (checkpoints_.empty()) {
+        std::cerr << "[error] rollback without checkpoint" << std::endl;
+        exit(1);
+    }
+    root_ = checkpoints_.back();
+    checkpoints_.pop_back();
+}
+
+
+void ZsddCompiler::release() {
+    if (checkpoints_.empty()) {
+        std::cerr << "[error] release without checkpoint" << std::endl;
+        exit(1);
+    }
+    checkpoints_.pop_back();
+}
+
+
+// a clause is falsified by the members without its positive literals
+// and with its negative literals. a term is satisfied by the members with
+// its positive literals and without its negative literals.
+Zsdd ZsddCompiler::filter_by_literals(const Zsdd& zsdd, const int* begin, const int* end) {
+    Zsdd res = zsdd;
+    for (const int* l = begin; l != end; ++l) {
+        int id;
+        if (*l == 0 || !mgr_.vtree().find_literal_node_id(abs(*l), id)) {
+            std::cerr << "[error] variable " << abs(*l) << " is not in the vtree" << std::endl;
+            exit(1);
+        }
+        if ((*l > 0) == (form_ == Form::CNF)) {
+            res = mgr_.zsdd_filter_not_contain(res, abs(*l));
+        } else {
+            res = mgr_.zsdd_filter_contain(res, abs(*l));
+        }
+    }
+    return res;
+}
+
+
+void ZsddCompiler::apply_parts(std::vector<Zsdd>& parts) {
+    if (parts.empty()) return;
+    // the parts are united pairwise, so that the operands stay balanced.
+    while (parts.size() > 1) {
+        std::vector<Zsdd> tmp;
+        tmp.reserve((parts.size() + 1) / 2);
+        for (size_t i = 0; i + 1 < parts.size(); i += 2) {
+            tmp.push_back(mgr_.zsdd_union(parts[i], parts[i+1]));
+        }
+        if (parts.size() % 2 == 1) {
+            tmp.push_back(parts.back());
+        }
+        parts.swap(tmp);
+    }
+    if (form_ == Form::CNF) {
+        root_ = mgr_.zsdd_difference(root_, parts[0]);
+    } else {
+        root_ = mgr_.zsdd_union(root_, parts[0]);
+    }
+}
+
+} // namespace zsdd
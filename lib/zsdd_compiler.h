@@ -0,0 +1,54 @@
+#ifndef ZSDD_COMPILER_H_
+#define ZSDD_COMPILER_H_
+#include <vector>
+#include "zsdd.h"
+#include "zsdd_fnf.h"
+
+namespace zsdd {
+
+// incremental compilation of a cnf (dnf) over the variables of the vtree.
+// batches of clauses are conjoined to the current root (terms are
+// disjoined with it) on the same manager, so that the computed table is
+// shared between batches. a clause removes the members of the root which
+// falsify it, which are found by filters on the root, so that a batch
+// costs the part of the root it touches rather than the whole formula.
+class ZsddCompiler {
+public:
+    enum class Form { CNF, DNF };
+
+    // the root starts from the power set (cnf) or the empty family (dnf).
+    ZsddCompiler(ZsddManager& mgr, const Form form);
+    // continue from a compiled root, e.g., one loaded from a file.
+    ZsddCompiler(ZsddManager& mgr, const Form form, const Zsdd& root);
+
+    // conjoin the clauses (disjoin the terms) of batch, and return the new root.
+    const Zsdd& add(const FnfFormula& batch);
+    const Zsdd& add(const std::vector<int>& literals);
+
+    const Zsdd& root() const { return root_; }
+    Form form() const { return form_; }
+
+    // save the current root, and return the number of saved roots.
+    // rollback() restores the last saved root and release() drops it,
+    // keeping the current root. saved roots are not collected by gc().
+    size_t checkpoint();
+    void rollback();
+    void release();
+    size_t num_checkpoints() const { return checkpoints_.size(); }
+
+private:
+    // the members of zsdd which falsify the clause (satisfy the term).
+    Zsdd filter_by_literals(const Zsdd& zsdd, const int* begin, const int* end);
+    // remove (add) the union of parts from (to) the root.
+    void apply_parts(std::vector<Zsdd>& parts);
+
+    ZsddManager& mgr_;
+    Form form_;
+    Zsdd universe_;
+    Zsdd root_;
+    std::vector<Zsdd> checkpoints_;
+};
+
+} // namespace zsdd
+
+#endif // ZSDD_COMPILER_H_
@@ -0,0 +1,162 @@
+#include "zsdd_manager.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <algorithm>
+#include "zsdd.h"
+
+namespace zsdd {
+
+namespace {
+
+// the dfs positions of the leaves of the variables, -1 out of the vtree.
+std::vector<int> leaf_positions(const VTree& vtree) {
+    std::vector<int> position_of;
+    for (int i = 0; i < static_cast<int>(vtree.size()); i++) {
+        const VTreeNode& n = vtree.get_node(i);
+        if (!n.is_leaf()) continue;
+        if (static_cast<size_t>(n.var()) >= position_of.size()) position_of.resize(n.var() + 1, -1);
+        position_of[n.var()] = vtree.leaf_begin(i);
+    }
+    return position_of;
+}
+
+
+int count_in(const VTree& vtree, const std::vector<int>& counts, const int i) {
+    return counts[vtree.leaf_end(i)] - counts[vtree.leaf_begin(i)];
+}
+
+} // namespace
+
+
+Zsdd ZsddManager::zsdd_condition(const Zsdd& z, const std::vector<int>& assignment) {
+    return zsdd_condition(z, std::vector<std::vector<int>>(1, assignment))[0];
+}
+
+
+std::vector<Zsdd> ZsddManager::zsdd_condition(const Zsdd& z,
+                                              const std::vector<std::vector<int>>& assignments) {
+    const std::vector<int> position_of = leaf_positions(vtree_);
+    const size_t num_leaves = vtree_.num_leaves();
+    std::vector<char> marks(num_leaves);
+    std::vector<int> assigned(num_leaves + 1);
+    std::vector<int> forced_in(num_leaves + 1);
+    std::vector<Zsdd> res;
+    res.reserve(assignments.size());
+    for (const auto& assignment : assignments) {
+        // 0: unassigned, 1: in, 2: out, 3: conflicting.
+        std::fill(marks.begin(), marks.end(), 0);
+        bool consistent = true;
+        for (auto l : assignment) {
+            const int v = abs(l);
+            if (v == 0) continue;
+            if (static_cast<size_t>(v) >= position_of.size() || position_of[v] < 0) {
+                // a variable out of the vtree is in no member.
+                if (l > 0) consistent = false;
+                continue;
+            }
+            marks[position_of[v]] |= (l > 0) ? 1 : 2;
+        }
+        std::vector<int> key;
+        for (size_t i = 0; i < num_leaves; i++) {
+            assigned[i+1] = assigned[i] + (marks[i] != 0);
+            forced_in[i+1] = forced_in[i] + (marks[i] == 1);
+            if (marks[i] == 3) consistent = false;
+        }
+        if (!consistent) {
+            res.push_back(make_zsdd_empty());
+            continue;
+        }
+        if (assigned[num_leaves] == 0) {
+            res.push_back(z);
+            continue;
+        }
+        for (auto l : assignment) {
+            const int v = abs(l);
+            if (v != 0 && static_cast<size_t>(v) < position_of.size() && position_of[v] >= 0) {
+                key.push_back(l);
+            }
+        }
+        std::sort(key.begin(), key.end());
+        key.erase(std::unique(key.begin(), key.end()), key.end());
+        // assignments share the ids with the variable sets of zsdd_exists,
+        // which are cached with other operations.
+        const addr_t id = variable_set_id(std::move(key));
+        addr_t r = zsdd_condition_scope(z.addr(), vtree_.root(), assigned, forced_in, id);
+        res.push_back(Zsdd(r, *this));
+    }
+    return res;
+}
+
+
+// zsdd as a family over the variables of vtree node scope, where the
+// variables out of the node of zsdd are absent.
+addr_t ZsddManager::zsdd_condition_scope(const addr_t zsdd, const int scope,
+                                         const std::vector<int>& assigned,
+                                         const std::vector<int>& forced_in,
+                                         const addr_t assignment_id) {
+    if (zsdd == ZSDD_FALSE || zsdd == ZSDD_NULL) return zsdd;
+    const int c = count_in(vtree_, forced_in, scope);
+    if (zsdd == ZSDD_EMPTY) {
+        return c == 0 ? ZSDD_EMPTY : ZSDD_FALSE;
+    }
+    if (c != count_in(vtree_, forced_in, get_zsddnode_at(zsdd).vtree_node_id())) {
+        return ZSDD_FALSE;
+    }
+    return zsdd_condition_inner(zsdd, assigned, forced_in, assignment_id);
+}
+
+
+addr_t ZsddManager::zsdd_condition_inner(const addr_t zsdd, const std::vector<int>& assigned,
+                                         const std::vector<int>& forced_in,
+                                         const addr_t assignment_id) {
+    // copy the node, since new nodes may reallocate the node table.
+    const ZsddNode n = get_zsddnode_at(zsdd);
+    const int v = n.vtree_node_id();
+    if (count_in(vtree_, assigned, v) == 0) {
+        return zsdd;
+    }
+    if (n.type() == NodeType::LIT) {
+        const addr_t literal = n.literal();
+        if (count_in(vtree_, forced_in, v) != 0) {
+            return literal > 0 ? zsdd : make_zsdd_literal_inner(-literal);
+        }
+        return literal > 0 ? ZSDD_FALSE : ZSDD_EMPTY;
+    }
+
+    {
+        addr_t cache = cache_table_.read_cache(Operation::CONDITION, zsdd, assignment_id);
+        if (cache != ZSDD_NULL) {
+            return cache;
+        }
+    }
+
+    const VTreeNode& vn = vtree_.get_node(v);
+    const int left = vn.left_child();
+    const int right = vn.right_child();
+    // subsets of disjoint primes are disjoint.
+    std::vector<std::pair<addr_t, addr_t>> candidates;
+    for (const auto& e : n.decomposition()) {
+        addr_t new_p = zsdd_condition_scope(e.first, left, assigned, forced_in, assignment_id);
+        if (new_p == ZSDD_FALSE) continue;
+        addr_t new_s = zsdd_condition_scope(e.second, right, assigned, forced_in, assignment_id);
+        if (new_s == ZSDD_FALSE) continue;
+        candidates.emplace_back(new_p, new_s);
+    }
+    addr_t new_res = ZSDD_FALSE;
+    if (!candidates.empty()) {
+        std::vector<ZsddElement> new_decomposition = compress_candidates(candidates);
+
+        // zero suppression
+        if (new_decomposition.size() == 1 && new_decomposition[0].first == ZSDD_EMPTY) {
+            new_res = new_decomposition[0].second;
+        } else if (new_decomposition.size() == 1 && new_decomposition[0].second == ZSDD_EMPTY) {
+            new_res = new_decomposition[0].first;
+        } else {
+            new_res = make_zsdd_decomposition(std::move(new_decomposition), v);
+        }
+    }
+    cache_table_.write_cache(Operation::CONDITION, zsdd, assignment_id, new_res);
+    return new_res;
+}
+
+} // namespace zsdd
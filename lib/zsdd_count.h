@@ -0,0 +1,147 @@
+#ifndef ZSDD_COUNT_H_
+#define ZSDD_COUNT_H_
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "zsdd_bigint.h"
+#include "zsdd_evaluate.h"
+#include "zsdd_manager.h"
+
+#ifdef __SIZEOF_INT128__
+#define ZSDD_HAS_INT128 1
+#endif
+
+namespace zsdd {
+
+#ifdef ZSDD_HAS_INT128
+__extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+// log2 of a model count. zero is -inf.
+struct LogCount {
+    double log2;
+};
+
+// number types for model counting. add_product(acc, a, b) does
+// acc += a * b and returns false if the result doesn't fit in the type.
+template <typename T> struct CountTraits;
+
+template <> struct CountTraits<unsigned long long> {
+    static unsigned long long zero() { return 0LLU; }
+    static unsigned long long one() { return 1LLU; }
+    static unsigned long long two() { return 2LLU; }
+    static bool add_product(unsigned long long& acc, const unsigned long long a,
+                            const unsigned long long b) {
+        unsigned long long p;
+        if (__builtin_mul_overflow(a, b, &p)) return false;
+        return !__builtin_add_overflow(acc, p, &acc);
+    }
+    static std::string to_string(const unsigned long long n) { return std::to_string(n); }
+};
+
+#ifdef ZSDD_HAS_INT128
+template <> struct CountTraits<uint128_t> {
+    static uint128_t zero() { return 0; }
+    static uint128_t one() { return 1; }
+    static uint128_t two() { return 2; }
+    static bool add_product(uint128_t& acc, const uint128_t a, const uint128_t b) {
+        uint128_t p;
+        if (__builtin_mul_overflow(a, b, &p)) return false;
+        return !__builtin_add_overflow(acc, p, &acc);
+    }
+    static std::string to_string(uint128_t n) {
+        if (n == 0) return "0";
+        std::string s;
+        for (; n != 0; n /= 10) s += static_cast<char>('0' + static_cast<int>(n % 10));
+        std::reverse(s.begin(), s.end());
+        return s;
+    }
+};
+#endif
+
+template <> struct CountTraits<BigInt> {
+    static BigInt zero() { return BigInt(); }
+    static BigInt one() { return BigInt(1); }
+    static BigInt two() { return BigInt(2); }
+    static bool add_product(BigInt& acc, const BigInt& a, const BigInt& b) {
+        acc.add_product(a, b);
+        return true;
+    }
+    static std::string to_string(const BigInt& n) { return n.to_string(); }
+};
+
+template <> struct CountTraits<LogCount> {
+    static LogCount zero() { return LogCount{-INFINITY}; }
+    static LogCount one() { return LogCount{0.0}; }
+    static LogCount two() { return LogCount{1.0}; }
+    static bool add_product(LogCount& acc, const LogCount a, const LogCount b) {
+        const double p = a.log2 + b.log2;
+        if (std::isinf(p)) return true;
+        if (std::isinf(acc.log2)) {
+            acc.log2 = p;
+            return true;
+        }
+        const double hi = std::max(acc.log2, p);
+        const double lo = std::min(acc.log2, p);
+        acc.log2 = hi + std::log2(1.0 + std::exp2(lo - hi));
+        return true;
+    }
+    static std::string to_string(const LogCount n) { return "2^" + std::to_string(n.log2); }
+};
+
+
+// exact number types, from the narrowest.
+enum class CountType : char {UINT64, UINT128, BIGINT};
+
+// a family over n variables has at most 2^n members.
+inline CountType exact_count_type(const size_t num_variables) {
+    if (num_variables < 64) return CountType::UINT64;
+#ifdef ZSDD_HAS_INT128
+    if (num_variables < 128) return CountType::UINT128;
+#endif
+    return CountType::BIGINT;
+}
+
+
+// count the members of zsdd in T. returns false on overflow.
+template <typename T>
+bool count_models(const ZsddManager& mgr, const addr_t zsdd, T& count) {
+    typedef CountTraits<T> Traits;
+    const T one = Traits::one();
+    const T two = Traits::two();
+    return evaluate(mgr, zsdd, Traits::zero(), one,
+                    [&one, &two](const int literal) { return literal < 0 ? two : one; },
+                    Traits::add_product, count);
+}
+
+
+// the number of members of each size in T: counts[i] is the number of
+// members with i variables. the values are polynomials in the size,
+// and an element multiplies the polynomials of its prime and sub.
+// returns false on overflow.
+template <typename T>
+bool count_models_by_size(const ZsddManager& mgr, const addr_t zsdd, std::vector<T>& counts) {
+    typedef CountTraits<T> Traits;
+    typedef std::vector<T> Polynomial;
+    const Polynomial positive = {Traits::zero(), Traits::one()};
+    const Polynomial negative = {Traits::one(), Traits::one()};
+    auto convolve = [](Polynomial& acc, const Polynomial& a, const Polynomial& b) {
+        if (a.empty() || b.empty()) return true;
+        if (acc.size() < a.size() + b.size() - 1) acc.resize(a.size() + b.size() - 1, Traits::zero());
+        for (size_t i = 0; i < a.size(); i++) {
+            T* const out = acc.data() + i;
+            for (size_t j = 0; j < b.size(); j++) {
+                if (!Traits::add_product(out[j], a[i], b[j])) return false;
+            }
+        }
+        return true;
+    };
+    return evaluate(mgr, zsdd, Polynomial(), Polynomial(1, Traits::one()),
+                    [&positive, &negative](const int literal) { return literal < 0 ? negative : positive; },
+                    convolve, counts);
+}
+
+} // namespace zsdd
+
+#endif // ZSDD_COUNT_H_
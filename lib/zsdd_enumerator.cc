@@ -0,0 +1,204 @@
+#include "zsdd_enumerator.h"
+#include <stdlib.h>
+#include <memory>
+#include "zsdd_manager.h"
+
+namespace zsdd {
+
+namespace {
+
+unsigned long long saturated_mul(const unsigned long long a, const unsigned long long b) {
+    unsigned long long r;
+    if (__builtin_mul_overflow(a, b, &r)) return std::numeric_limits<unsigned long long>::max();
+    return r;
+}
+
+
+unsigned long long saturated_add(const unsigned long long a, const unsigned long long b) {
+    unsigned long long r;
+    if (__builtin_add_overflow(a, b, &r)) return std::numeric_limits<unsigned long long>::max();
+    return r;
+}
+
+} // namespace
+
+
+ZsddEnumerator::ZsddEnumerator(const ZsddManager& mgr, const addr_t zsdd) :
+    mgr_(mgr), root_(zsdd), frames_(), pending_(), set_(),
+    position_(0), valid_(false), counts_() {
+    if (root_ == ZSDD_FALSE) return;
+    pending_.push_back(root_);
+    descend();
+    valid_ = true;
+}
+
+
+bool ZsddEnumerator::first_choice(const addr_t zsdd, size_t& choice) const {
+    choice = 0;
+    if (zsdd == ZSDD_FALSE) return false;
+    if (zsdd == ZSDD_EMPTY) return true;
+    const ZsddNode& n = mgr_.get_zsddnode_at(zsdd);
+    if (n.type() == NodeType::LIT) return true;
+    const auto& decomp = n.decomposition();
+    for (; choice < decomp.size(); choice++) {
+        if (decomp[choice].first != ZSDD_FALSE && decomp[choice].second != ZSDD_FALSE) return true;
+    }
+    return false;
+}
+
+
+bool ZsddEnumerator::next_choice(const addr_t zsdd, size_t& choice) const {
+    if (zsdd == ZSDD_EMPTY) return false;
+    const ZsddNode& n = mgr_.get_zsddnode_at(zsdd);
+    if (n.type() == NodeType::LIT) {
+        if (n.literal() > 0 || choice == 1) return false;
+        choice = 1;
+        return true;
+    }
+    const auto& decomp = n.decomposition();
+    for (size_t i = choice + 1; i < decomp.size(); i++) {
+        if (decomp[i].first != ZSDD_FALSE && decomp[i].second != ZSDD_FALSE) {
+            choice = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void ZsddEnumerator::apply_choice(const Frame& f) {
+    if (f.zsdd == ZSDD_EMPTY) return;
+    const ZsddNode& n = mgr_.get_zsddnode_at(f.zsdd);
+    if (n.type() == NodeType::LIT) {
+        if (n.literal() > 0 || f.choice == 1) set_.push_back(abs(n.literal()));
+        return;
+    }
+    const ZsddElement& e = n.decomposition()[f.choice];
+    pending_.push_back(e.second);
+    pending_.push_back(e.first);
+}
+
+
+void ZsddEnumerator::undo_choice(const Frame& f) {
+    if (f.zsdd == ZSDD_EMPTY) return;
+    const ZsddNode& n = mgr_.get_zsddnode_at(f.zsdd);
+    if (n.type() == NodeType::LIT) {
+        if (n.literal() > 0 || f.choice == 1) set_.pop_back();
+        return;
+    }
+    pending_.pop_back();
+    pending_.pop_back();
+}
+
+
+// expand the pending nodes with their first choices.
+void ZsddEnumerator::descend() {
+    while (!pending_.empty()) {
+        Frame f = {pending_.back(), 0};
+        pending_.pop_back();
+        first_choice(f.zsdd, f.choice);
+        frames_.push_back(f);
+        apply_choice(f);
+    }
+}
+
+
+void ZsddEnumerator::next() {
+    if (!valid_) return;
+    position_++;
+    // the last frame changes first, and the frames after a changed
+    // frame restart from their first choices.
+    while (!frames_.empty()) {
+        Frame& f = frames_.back();
+        undo_choice(f);
+        if (next_choice(f.zsdd, f.choice)) {
+            apply_choice(f);
+            descend();
+            return;
+        }
+        pending_.push_back(f.zsdd);
+        frames_.pop_back();
+    }
+    valid_ = false;
+}
+
+
+void ZsddEnumerator::seek(const unsigned long long position) {
+    frames_.clear();
+    pending_.clear();
+    set_.clear();
+    position_ = position;
+    valid_ = false;
+    if (root_ == ZSDD_FALSE || position >= count_of(root_)) return;
+
+    // position is the rank among the members of the pending nodes, in which
+    // the last pending node is the most significant.
+    unsigned long long rank = position;
+    pending_.push_back(root_);
+    while (!pending_.empty()) {
+        Frame f = {pending_.back(), 0};
+        pending_.pop_back();
+        unsigned long long rest = 1;
+        for (const auto z : pending_) {
+            rest = saturated_mul(rest, count_of(z));
+        }
+        unsigned long long idx = rank / rest;
+        const unsigned long long rest_rank = rank % rest;
+        rank = rest_rank;
+        if (f.zsdd == ZSDD_EMPTY) {
+            // the only choice.
+        } else if (mgr_.get_zsddnode_at(f.zsdd).type() == NodeType::LIT) {
+            f.choice = idx;
+        } else {
+            const auto& decomp = mgr_.get_zsddnode_at(f.zsdd).decomposition();
+            for (f.choice = 0; f.choice < decomp.size(); f.choice++) {
+                const unsigned long long c = saturated_mul(count_of(decomp[f.choice].first),
+                                                           count_of(decomp[f.choice].second));
+                if (idx < c) break;
+                idx -= c;
+            }
+            rank = idx * rest + rest_rank;
+        }
+        frames_.push_back(f);
+        apply_choice(f);
+    }
+    valid_ = true;
+}
+
+
+unsigned long long ZsddEnumerator::count_of(const addr_t zsdd) {
+    if (zsdd == ZSDD_FALSE) return 0;
+    if (zsdd == ZSDD_EMPTY) return 1;
+    if (counts_.empty()) {
+        const std::shared_ptr<const EvaluationOrder> order = mgr_.evaluation_order(root_);
+        std::vector<unsigned long long> c(2 + order->nodes.size());
+        c[0] = 0;
+        c[1] = 1;
+        for (size_t i = 0; i < order->nodes.size(); i++) {
+            if (order->literals[i] != 0) {
+                c[i+2] = order->literals[i] < 0 ? 2 : 1;
+            } else {
+                c[i+2] = 0;
+                for (size_t k = order->offsets[i]; k < order->offsets[i+1]; k++) {
+                    const auto& e = order->elements[k];
+                    c[i+2] = saturated_add(c[i+2], saturated_mul(c[e.first], c[e.second]));
+                }
+            }
+            counts_.emplace(order->nodes[i], c[i+2]);
+        }
+    }
+    return counts_.at(zsdd);
+}
+
+
+void enumerate(const ZsddManager& mgr, const addr_t zsdd,
+               const std::function<bool(const std::vector<int>&)>& visitor,
+               const unsigned long long offset, const unsigned long long limit) {
+    ZsddEnumerator e(mgr, zsdd);
+    if (offset > 0) e.seek(offset);
+    for (unsigned long long n = 0; n < limit && e.valid(); n++, e.next()) {
+        if (!visitor(e.current())) return;
+    }
+}
+
+} // namespace zsdd
@@ -0,0 +1,66 @@
+#ifndef ZSDD_ENUMERATOR_H_
+#define ZSDD_ENUMERATOR_H_
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "zsdd_common.h"
+
+namespace zsdd {
+
+class ZsddManager;
+
+// enumerates the members of a zsdd one at a time without materializing
+// the family. the state is an explicit stack of choices, so that memory
+// is proportional to the size of the vtree. members are visited in a
+// fixed order, and position() can be used to resume with seek() later.
+// mgr must not be garbage-collected during the enumeration.
+class ZsddEnumerator {
+public:
+    ZsddEnumerator(const ZsddManager& mgr, const addr_t zsdd);
+
+    // false after the last member.
+    bool valid() const { return valid_; }
+    // the current member. the buffer is reused by next().
+    const std::vector<int>& current() const { return set_; }
+    // the index of the current member.
+    unsigned long long position() const { return position_; }
+
+    void next();
+    // move to the member of the given index.
+    void seek(const unsigned long long position);
+
+private:
+    struct Frame {
+        addr_t zsdd;
+        size_t choice; // element index, or 0/1 for {}/{v} of negative literals
+    };
+
+    const ZsddManager& mgr_;
+    const addr_t root_;
+    std::vector<Frame> frames_;
+    std::vector<addr_t> pending_; // nodes to be expanded
+    std::vector<int> set_;
+    unsigned long long position_;
+    bool valid_;
+    std::unordered_map<addr_t, unsigned long long> counts_; // for seek, saturated
+
+    bool first_choice(const addr_t zsdd, size_t& choice) const;
+    bool next_choice(const addr_t zsdd, size_t& choice) const;
+    void apply_choice(const Frame& f);
+    void undo_choice(const Frame& f);
+    void descend();
+    unsigned long long count_of(const addr_t zsdd);
+};
+
+
+// call visitor for at most limit members from the offset-th member.
+// the enumeration stops when visitor returns false.
+void enumerate(const ZsddManager& mgr, const addr_t zsdd,
+               const std::function<bool(const std::vector<int>&)>& visitor,
+               const unsigned long long offset = 0,
+               const unsigned long long limit = std::numeric_limits<unsigned long long>::max());
+
+} // namespace zsdd
+
+#endif // ZSDD_ENUMERATOR_H_
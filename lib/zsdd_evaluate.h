@@ -0,0 +1,47 @@
+#ifndef ZSDD_EVALUATE_H_
+#define ZSDD_EVALUATE_H_
+#include <memory>
+#include <vector>
+#include "zsdd_manager.h"
+
+namespace zsdd {
+
+// bottom-up fold of zsdd over a semiring. zero and one are the values of
+// ZSDD_FALSE and ZSDD_EMPTY, literal(l) gives the value of a literal node,
+// and add_product(acc, p, s) adds the value of an element (p, s) to acc,
+// which starts from zero. the fold stops when add_product returns false.
+// values are kept in a dense array indexed by positions of
+// ZsddManager::evaluation_order, which is cached between calls.
+template <typename T, typename Literal, typename AddProduct>
+bool evaluate(const ZsddManager& mgr, const addr_t zsdd, const T& zero, const T& one,
+              Literal literal, AddProduct add_product, T& result) {
+    if (zsdd == ZSDD_EMPTY || zsdd == ZSDD_FALSE) {
+        result = (zsdd == ZSDD_EMPTY) ? one : zero;
+        return true;
+    }
+    const std::shared_ptr<const EvaluationOrder> order = mgr.evaluation_order(zsdd);
+    const size_t num_nodes = order->nodes.size();
+    std::vector<T> values;
+    values.reserve(num_nodes + 2);
+    values.push_back(zero);
+    values.push_back(one);
+    for (size_t i = 0; i < num_nodes; i++) {
+        if (order->literals[i] != 0) {
+            values.push_back(literal(order->literals[i]));
+            continue;
+        }
+        T acc = zero;
+        for (size_t k = order->offsets[i]; k < order->offsets[i+1]; k++) {
+            const auto& e = order->elements[k];
+            if (!add_product(acc, values[e.first], values[e.second])) return false;
+        }
+        values.push_back(std::move(acc));
+    }
+    // the root is the last node.
+    result = std::move(values.back());
+    return true;
+}
+
+} // namespace zsdd
+
+#endif // ZSDD_EVALUATE_H_
@@ -0,0 +1,445 @@
+#include "zsdd_fnf.h"
+#include "zsdd_mapped_file.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#ifdef ZSDD_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace zsdd {
+
+namespace {
+
+bool is_space(const char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+
+// incremental dimacs scanner. the input can be fed in arbitrary pieces,
+// so that the same code parses mapped files and decompressed streams.
+// a chunk of a mapped file starting at chunk_begin counts its lines from
+// file_begin, which is only done to report an error.
+class DimacsScanner {
+public:
+    DimacsScanner(FnfFormula& out, const bool at_line_start, const std::string& file_name,
+                  const char* file_begin = nullptr, const char* chunk_begin = nullptr) :
+        out_(out),
+        state_(at_line_start ? LINE_START : BODY),
+        value_(0),
+        negative_(false),
+        in_number_(false),
+        pending_literals_(false),
+        header_(),
+        header_seen_(false),
+        form_(),
+        file_name_(file_name),
+        file_begin_(file_begin),
+        chunk_begin_(chunk_begin),
+        line_(1) {}
+
+    void feed(const char* p, const char* end) {
+        while (p != end) {
+            const char c = *p++;
+            switch (state_) {
+            case LINE_START:
+                if (c == 'c') {
+                    state_ = COMMENT;
+                    break;
+                } else if (c == 'p') {
+                    state_ = HEADER;
+                    header_.assign(1, c);
+                    break;
+                } else if (c == '%') {
+                    state_ = DONE;
+                    break;
+                }
+                state_ = BODY;
+                // fall through
+            case BODY:
+                if (c >= '0' && c <= '9') {
+                    if (value_ > (INT_MAX - (c - '0')) / 10) {
+                        error("literal out of range");
+                    }
+                    value_ = value_ * 10 + (c - '0');
+                    in_number_ = true;
+                } else if (c == '-' && !negative_ && !in_number_) {
+                    negative_ = true;
+                } else if (is_space(c)) {
+                    flush_number();
+                    if (c == '\n') state_ = LINE_START;
+                } else {
+                    error(std::string("unexpected character '") + c + "'");
+                }
+                break;
+            case COMMENT:
+                if (c == '\n') state_ = LINE_START;
+                break;
+            case HEADER:
+                if (c == '\n') {
+                    parse_header();
+                    state_ = LINE_START;
+                } else {
+                    header_.push_back(c);
+                }
+                break;
+            case DONE:
+                return;
+            }
+            if (c == '\n') ++line_;
+        }
+    }
+
+    void finish() {
+        if (state_ == HEADER) parse_header();
+        flush_number();
+        // be lenient with a missing terminating zero.
+        if (pending_literals_) {
+            out_.close_clause();
+            pending_literals_ = false;
+        }
+    }
+
+    bool header_seen() const { return header_seen_; }
+    const std::string& form() const { return form_; }
+
+private:
+    enum State {LINE_START, BODY, COMMENT, HEADER, DONE};
+
+    FnfFormula& out_;
+    State state_;
+    int value_;
+    bool negative_;
+    bool in_number_;
+    bool pending_literals_;
+    std::string header_;
+    bool header_seen_;
+    std::string form_;
+    const std::string& file_name_;
+    const char* file_begin_;
+    const char* chunk_begin_;
+    size_t line_;
+
+    void error(const std::string& message) const {
+        const size_t line = line_ + (file_begin_ == nullptr ? 0 :
+                                     std::count(file_begin_, chunk_begin_, '\n'));
+        std::cerr << "[error] " << message << " at line " << line << " of "
+                  << file_name_ << std::endl;
+        exit(1);
+    }
+
+    void flush_number() {
+        if (!in_number_) {
+            if (negative_) error("'-' without a number");
+            return;
+        }
+        if (value_ == 0) {
+            out_.close_clause();
+            pending_literals_ = false;
+        } else {
+            out_.push_literal(negative_ ? -value_ : value_);
+            pending_literals_ = true;
+        }
+        value_ = 0;
+        negative_ = false;
+        in_number_ = false;
+    }
+
+    void parse_header() {
+        std::istringstream is(header_);
+        std::string p;
+        int num_variables = 0;
+        is >> p >> form_ >> num_variables;
+        out_.set_num_variables(num_variables);
+        header_seen_ = true;
+    }
+};
+
+
+// returns the end of the problem line, or end if there is none.
+const char* find_header_end(const char* p, const char* end) {
+    bool line_start = true;
+    bool in_header = false;
+    for (; p != end; ++p) {
+        if (line_start) {
+            in_header = (*p == 'p');
+        }
+        line_start = (*p == '\n');
+        if (line_start && in_header) return p + 1;
+    }
+    return end;
+}
+
+
+// returns the position just after the first clause terminator at or after p.
+const char* find_clause_boundary(const char* p, const char* begin, const char* end) {
+    while (p != end && p != begin && p[-1] != '\n') ++p;
+    bool line_start = true;
+    while (p != end) {
+        if (line_start && *p == 'c') {
+            while (p != end && *p != '\n') ++p;
+            continue;
+        }
+        line_start = (*p == '\n');
+        if (*p == '0' && (p == begin || is_space(p[-1])) && (p + 1 == end || is_space(p[1]))) {
+            return p + 1;
+        }
+        ++p;
+    }
+    return end;
+}
+
+
+bool is_gzip(const MappedFile& file) {
+    return file.size() >= 2 &&
+        static_cast<unsigned char>(file.data()[0]) == 0x1f &&
+        static_cast<unsigned char>(file.data()[1]) == 0x8b;
+}
+
+
+void check_header(const bool header_seen, const std::string& file_name) {
+    if (!header_seen) {
+        std::cerr << "[error] no problem line in " << file_name << std::endl;
+        exit(1);
+    }
+}
+
+
+// feed a gzip-compressed file to scanner.
+template <typename Scanner>
+void feed_gzip(const std::string& file_name, Scanner& scanner) {
+#ifdef ZSDD_USE_ZLIB
+    gzFile gz = gzopen(file_name.c_str(), "rb");
+    if (gz == nullptr) {
+        std::cerr << "can't read " << file_name << std::endl;
+        exit(1);
+    }
+    gzbuffer(gz, 1U << 20);
+    std::vector<char> buf(1U << 20);
+    int n;
+    while ((n = gzread(gz, buf.data(), buf.size())) > 0) {
+        scanner.feed(buf.data(), buf.data() + n);
+    }
+    if (n < 0) {
+        std::cerr << "[error] broken gzip stream in " << file_name << std::endl;
+        exit(1);
+    }
+    gzclose(gz);
+#else
+    (void)scanner;
+    std::cerr << "[error] " << file_name
+              << " is gzip-compressed, but zsdd is built without zlib" << std::endl;
+    exit(1);
+#endif
+}
+
+
+FnfFormula read_gzip_dimacs(const std::string& file_name, std::string* form) {
+    FnfFormula res;
+    DimacsScanner scanner(res, true, file_name);
+    feed_gzip(file_name, scanner);
+    scanner.finish();
+    check_header(scanner.header_seen(), file_name);
+    if (form != nullptr) *form = scanner.form();
+    return res;
+}
+
+
+// a set per line, with variables separated by spaces.
+class SetFamilyScanner {
+public:
+    SetFamilyScanner(std::vector<int>& vars, std::vector<size_t>& offsets,
+                     const std::string& file_name) :
+        vars_(vars), offsets_(offsets), value_(0), in_number_(false),
+        line_started_(false), max_var_(0), file_name_(file_name), line_(1) {}
+
+    void feed(const char* p, const char* end) {
+        for (; p != end; ++p) {
+            const char c = *p;
+            if (c >= '0' && c <= '9') {
+                if (value_ > (INT_MAX - (c - '0')) / 10) {
+                    error("variable out of range");
+                }
+                value_ = value_ * 10 + (c - '0');
+                in_number_ = true;
+                line_started_ = true;
+            } else if (c == '\n') {
+                flush_number();
+                offsets_.push_back(vars_.size());
+                line_started_ = false;
+                ++line_;
+            } else if (c == ' ' || c == '\t' || c == '\r') {
+                flush_number();
+            } else {
+                error(std::string("unexpected character '") + c + "'");
+            }
+        }
+    }
+
+    // a last line without a newline.
+    void finish() {
+        flush_number();
+        if (line_started_) offsets_.push_back(vars_.size());
+    }
+
+    int max_var() const { return max_var_; }
+
+private:
+    std::vector<int>& vars_;
+    std::vector<size_t>& offsets_;
+    int value_;
+    bool in_number_;
+    bool line_started_;
+    int max_var_;
+    const std::string& file_name_;
+    size_t line_;
+
+    void error(const std::string& message) const {
+        std::cerr << "[error] " << message << " at line " << line_ << " of "
+                  << file_name_ << std::endl;
+        exit(1);
+    }
+
+    void flush_number() {
+        if (!in_number_) return;
+        if (value_ == 0) {
+            error("variable 0");
+        }
+        vars_.push_back(value_);
+        max_var_ = std::max(max_var_, value_);
+        value_ = 0;
+        in_number_ = false;
+    }
+};
+
+} // namespace
+
+
+void FnfFormula::append(const FnfFormula& obj) {
+    const size_t base = literals_.size();
+    literals_.insert(literals_.end(), obj.literals_.begin(), obj.literals_.end());
+    offsets_.reserve(offsets_.size() + obj.size());
+    for (size_t i = 1; i < obj.offsets_.size(); i++) {
+        offsets_.push_back(base + obj.offsets_[i]);
+    }
+}
+
+
+uint64_t FnfFormula::fingerprint() const {
+    // fnv-1a on the values, so that it doesn't depend on std::hash.
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](const uint64_t v) {
+        h ^= v;
+        h *= 1099511628211ULL;
+    };
+    mix(num_variables_);
+    mix(size());
+    for (size_t i = 0; i < size(); i++) {
+        mix(offsets_[i+1] - offsets_[i]);
+        for (size_t j = offsets_[i]; j < offsets_[i+1]; j++) {
+            mix(static_cast<uint64_t>(static_cast<int64_t>(literals_[j])));
+        }
+    }
+    return h;
+}
+
+
+FnfFormula FnfFormula::read_dimacs(const std::string& file_name,
+                                   const unsigned int num_threads,
+                                   std::string* form) {
+    MappedFile file;
+    if (!file.open(file_name)) {
+        std::cerr << "can't read " << file_name << std::endl;
+        exit(1);
+    }
+    if (is_gzip(file)) {
+        file.close();
+        return read_gzip_dimacs(file_name, form);
+    }
+
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    // small inputs are not worth splitting.
+    const size_t MIN_CHUNK_SIZE = 1U << 20;
+    size_t num_chunks = num_threads > 0 ? num_threads : 1;
+    if (file.size() / MIN_CHUNK_SIZE < num_chunks) {
+        num_chunks = file.size() / MIN_CHUNK_SIZE + 1;
+    }
+
+    // chunk k covers [bounds[k], bounds[k+1]).
+    // chunk 0 starts at the beginning of the file and parses the header.
+    const char* body = find_header_end(begin, end);
+    std::vector<const char*> bounds(1, begin);
+    for (size_t k = 1; k < num_chunks; k++) {
+        const char* p = begin + file.size() / num_chunks * k;
+        if (p < body) p = body;
+        p = find_clause_boundary(p, begin, end);
+        if (p > bounds.back() && p < end) bounds.push_back(p);
+    }
+    bounds.push_back(end);
+
+    const size_t n = bounds.size() - 1;
+    std::vector<FnfFormula> parts(n);
+    // not vector<bool>, since workers write their flags concurrently.
+    std::vector<char> header_seen(n, false);
+    std::vector<std::string> forms(n);
+    auto parse = [&](const size_t k) {
+        const char* b = bounds[k];
+        DimacsScanner scanner(parts[k], b == begin || b[-1] == '\n', file_name, begin, b);
+        scanner.feed(b, bounds[k+1]);
+        scanner.finish();
+        header_seen[k] = scanner.header_seen();
+        forms[k] = scanner.form();
+    };
+    std::vector<std::thread> workers;
+    for (size_t k = 1; k < n; k++) {
+        workers.emplace_back(parse, k);
+    }
+    parse(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    check_header(header_seen[0], file_name);
+    if (form != nullptr) *form = forms[0];
+
+    FnfFormula& res = parts[0];
+    if (n > 1) {
+        size_t num_clauses = 0;
+        size_t num_literals = 0;
+        for (const auto& part : parts) {
+            num_clauses += part.size();
+            num_literals += part.num_literals();
+        }
+        res.reserve(num_clauses, num_literals);
+        for (size_t k = 1; k < n; k++) {
+            res.append(parts[k]);
+        }
+    }
+    return std::move(res);
+}
+
+
+int read_setfamily(const std::string& file_name, std::vector<int>& vars,
+                   std::vector<size_t>& offsets) {
+    vars.clear();
+    offsets.assign(1, 0);
+    SetFamilyScanner scanner(vars, offsets, file_name);
+    MappedFile file;
+    if (!file.open(file_name)) {
+        std::cerr << "can't read " << file_name << std::endl;
+        exit(1);
+    }
+    if (is_gzip(file)) {
+        file.close();
+        feed_gzip(file_name, scanner);
+    } else {
+        scanner.feed(file.data(), file.data() + file.size());
+    }
+    scanner.finish();
+    return scanner.max_var();
+}
+
+} // namespace zsdd
@@ -0,0 +1,83 @@
+#ifndef ZSDD_FNF_H_
+#define ZSDD_FNF_H_
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace zsdd {
+
+// a cnf/dnf formula. the literals of all clauses (or terms) are stored
+// in one flat buffer, and clause i is literals_[offsets_[i], offsets_[i+1]).
+class FnfFormula {
+public:
+    class Clause {
+    public:
+        Clause(const int* begin, const int* end) : begin_(begin), end_(end) {}
+        const int* begin() const { return begin_; }
+        const int* end() const { return end_; }
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+        int operator[](const size_t i) const { return begin_[i]; }
+    private:
+        const int* begin_;
+        const int* end_;
+    };
+
+    FnfFormula() : num_variables_(0), literals_(), offsets_(1, 0) {}
+    explicit FnfFormula(const int num_variables) :
+        num_variables_(num_variables), literals_(), offsets_(1, 0) {}
+
+    int num_variables() const { return num_variables_; }
+    void set_num_variables(const int num_variables) { num_variables_ = num_variables; }
+
+    size_t size() const { return offsets_.size() - 1; }
+    bool empty() const { return size() == 0; }
+    size_t num_literals() const { return literals_.size(); }
+
+    Clause operator[](const size_t i) const {
+        return Clause(literals_.data() + offsets_[i], literals_.data() + offsets_[i+1]);
+    }
+
+    // build a clause literal by literal.
+    void push_literal(const int literal) { literals_.push_back(literal); }
+    void close_clause() { offsets_.push_back(literals_.size()); }
+
+    template <typename InputIt>
+    void add_clause(InputIt first, InputIt last) {
+        literals_.insert(literals_.end(), first, last);
+        close_clause();
+    }
+
+    void append(const FnfFormula& obj);
+    // a hash of the number of variables and the clauses, which is
+    // the same across runs.
+    uint64_t fingerprint() const;
+    void reserve(const size_t num_clauses, const size_t num_literals) {
+        offsets_.reserve(num_clauses + 1);
+        literals_.reserve(num_literals);
+    }
+
+    // read a dimacs cnf/dnf file. the file is memory-mapped and parsed
+    // by num_threads threads. gzip-compressed files are decompressed on the fly.
+    // form is set to the format name in the problem line ("cnf" or "dnf").
+    static FnfFormula read_dimacs(const std::string& file_name,
+                                  const unsigned int num_threads = 1,
+                                  std::string* form = nullptr);
+
+private:
+    int num_variables_;
+    std::vector<int> literals_;
+    std::vector<size_t> offsets_;
+};
+
+
+// read a set family file: a set per line, whose variables are separated
+// by spaces. an empty line is the empty set. set i is
+// vars[offsets[i], offsets[i+1]). returns the largest variable.
+int read_setfamily(const std::string& file_name, std::vector<int>& vars,
+                   std::vector<size_t>& offsets);
+
+} // namespace zsdd
+
+#endif // ZSDD_FNF_H_
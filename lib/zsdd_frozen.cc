@@ -0,0 +1,531 @@
+#include "zsdd_frozen.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stack>
+#include <unordered_map>
+#include "zsdd.h"
+#include "zsdd_sampler.h"
+
+namespace zsdd {
+
+namespace {
+
+const char FROZEN_MAGIC[8] = {'Z', 'S', 'D', 'D', 'F', 'R', 'Z', '\0'};
+const uint32_t FROZEN_VERSION = 1;
+
+
+size_t align8(const size_t n) {
+    return (n + 7) & ~static_cast<size_t>(7);
+}
+
+
+// byte offsets of the sections, which follow the header in this order.
+struct Layout {
+    size_t vtree;
+    size_t var_position;
+    size_t node_vtree;
+    size_t node_literal;
+    size_t node_offsets;
+    size_t elements;
+    size_t roots;
+    size_t total;
+};
+
+
+Layout compute_layout(const FrozenZsdd::Header& h) {
+    Layout l;
+    l.vtree = align8(sizeof(FrozenZsdd::Header));
+    l.var_position = l.vtree + align8(h.num_vtree_nodes * sizeof(FrozenZsdd::VTreeEntry));
+    l.node_vtree = l.var_position + align8((h.max_var + 1) * sizeof(int32_t));
+    l.node_literal = l.node_vtree + align8(h.num_nodes * sizeof(int32_t));
+    l.node_offsets = l.node_literal + align8(h.num_nodes * sizeof(int32_t));
+    l.elements = l.node_offsets + (h.num_nodes + 1) * sizeof(uint64_t);
+    l.roots = l.elements + h.num_elements * sizeof(FrozenZsdd::Element);
+    l.total = l.roots + h.num_roots * sizeof(int64_t);
+    return l;
+}
+
+
+int32_t count_in_range(const std::vector<int32_t>& positions,
+                       const int32_t begin, const int32_t end) {
+    return std::lower_bound(positions.begin(), positions.end(), end) -
+        std::lower_bound(positions.begin(), positions.end(), begin);
+}
+
+// the frozen image of zsdds of mgr. size is set to its size in bytes.
+std::vector<uint64_t> build_image(const ZsddManager& mgr, const std::vector<Zsdd>& zsdds,
+                                  size_t& size) {
+    typedef FrozenZsdd::Header Header;
+    typedef FrozenZsdd::VTreeEntry VTreeEntry;
+    typedef FrozenZsdd::Element Element;
+    const VTree& vtree = mgr.vtree();
+    std::vector<addr_t> roots;
+    for (const auto& z : zsdds) {
+        roots.push_back(z.addr());
+    }
+    const std::vector<addr_t> nodes = mgr.collect_nodes_bottom_up(roots);
+    std::unordered_map<addr_t, int64_t> index;
+    index.reserve(nodes.size());
+    size_t num_elements = 0;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        index.emplace(nodes[i], i);
+        num_elements += mgr.get_zsddnode_at(nodes[i]).decomposition().size();
+    }
+    auto ref = [&index](const addr_t zsdd) -> int64_t {
+        return zsdd < 0 ? zsdd : index.at(zsdd);
+    };
+
+    Header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FROZEN_MAGIC, sizeof(FROZEN_MAGIC));
+    h.version = FROZEN_VERSION;
+    h.num_roots = roots.size();
+    h.num_vtree_nodes = vtree.size();
+    h.max_var = 0;
+    for (size_t i = 0; i < vtree.size(); i++) {
+        const VTreeNode& v = vtree.get_node(i);
+        if (v.parent() < 0) h.vtree_root = i;
+        if (v.is_leaf() && static_cast<uint64_t>(v.var()) > h.max_var) h.max_var = v.var();
+    }
+    h.num_nodes = nodes.size();
+    h.num_elements = num_elements;
+    const Layout l = compute_layout(h);
+
+    std::vector<uint64_t> buf(align8(l.total) / sizeof(uint64_t), 0);
+    char* image = reinterpret_cast<char*>(buf.data());
+    memcpy(image, &h, sizeof(h));
+
+    // number the leaves in dfs order.
+    VTreeEntry* ventries = reinterpret_cast<VTreeEntry*>(image + l.vtree);
+    int32_t* var_position = reinterpret_cast<int32_t*>(image + l.var_position);
+    std::fill(var_position, var_position + h.max_var + 1, -1);
+    {
+        int32_t num_leaves = 0;
+        std::stack<std::pair<int, bool>> unexpanded;
+        unexpanded.emplace(h.vtree_root, false);
+        while (!unexpanded.empty()) {
+            const auto top = unexpanded.top();
+            unexpanded.pop();
+            const VTreeNode& v = vtree.get_node(top.first);
+            VTreeEntry& e = ventries[top.first];
+            if (v.is_leaf()) {
+                e.left = -v.var();
+                e.right = 0;
+                e.parent = v.parent();
+                e.leaf_begin = num_leaves;
+                e.leaf_end = num_leaves + 1;
+                var_position[v.var()] = num_leaves++;
+            } else if (!top.second) {
+                e.left = v.left_child();
+                e.right = v.right_child();
+                e.parent = v.parent();
+                unexpanded.emplace(top.first, true);
+                unexpanded.emplace(v.right_child(), false);
+                unexpanded.emplace(v.left_child(), false);
+            } else {
+                e.leaf_begin = ventries[v.left_child()].leaf_begin;
+                e.leaf_end = ventries[v.right_child()].leaf_end;
+            }
+        }
+    }
+
+    int32_t* node_vtree = reinterpret_cast<int32_t*>(image + l.node_vtree);
+    int32_t* node_literal = reinterpret_cast<int32_t*>(image + l.node_literal);
+    uint64_t* node_offsets = reinterpret_cast<uint64_t*>(image + l.node_offsets);
+    Element* elements = reinterpret_cast<Element*>(image + l.elements);
+    int64_t* root_refs = reinterpret_cast<int64_t*>(image + l.roots);
+    uint64_t k = 0;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const ZsddNode& n = mgr.get_zsddnode_at(nodes[i]);
+        node_vtree[i] = n.vtree_node_id();
+        node_literal[i] = (n.type() == NodeType::LIT) ? n.literal() : 0;
+        node_offsets[i] = k;
+        for (const auto& e : n.decomposition()) {
+            elements[k].prime = ref(e.first);
+            elements[k].sub = ref(e.second);
+            k++;
+        }
+    }
+    node_offsets[nodes.size()] = k;
+    for (size_t i = 0; i < roots.size(); i++) {
+        root_refs[i] = ref(roots[i]);
+    }
+    size = l.total;
+    return buf;
+}
+
+} // namespace
+
+
+FrozenZsdd::FrozenZsdd(const std::string& file_name) : file_(), image_() {
+    if (!file_.open(file_name, MADV_NORMAL)) {
+        std::cerr << "can't read " << file_name << std::endl;
+        exit(1);
+    }
+    setup(file_.data(), file_.size(), file_name);
+}
+
+
+FrozenZsdd::FrozenZsdd(const ZsddManager& mgr, const std::vector<Zsdd>& zsdds) : file_(), image_() {
+    size_t size = 0;
+    image_ = build_image(mgr, zsdds, size);
+    setup(reinterpret_cast<const char*>(image_.data()), size, "frozen zsdd");
+}
+
+
+std::shared_ptr<const FrozenZsdd> ZsddManager::freeze(const std::vector<Zsdd>& zsdds) const {
+    return std::make_shared<const FrozenZsdd>(*this, zsdds);
+}
+
+
+void FrozenZsdd::write(const ZsddManager& mgr, const std::vector<Zsdd>& zsdds,
+                       const std::string& file_name) {
+    size_t size = 0;
+    const std::vector<uint64_t> image = build_image(mgr, zsdds, size);
+    std::ofstream ofs(file_name, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(image.data()), size);
+    if (!ofs) {
+        std::cerr << "[error] can't write " << file_name << std::endl;
+        exit(1);
+    }
+}
+
+
+void FrozenZsdd::setup(const char* image, const size_t size, const std::string& name) {
+    header_ = reinterpret_cast<const Header*>(image);
+    if (size < sizeof(Header) || memcmp(header_->magic, FROZEN_MAGIC, sizeof(FROZEN_MAGIC)) != 0) {
+        std::cerr << "[error] " << name << " is not a frozen zsdd file" << std::endl;
+        exit(1);
+    }
+    if (header_->version != FROZEN_VERSION) {
+        std::cerr << "[error] unsupported frozen zsdd version " << header_->version
+                  << " in " << name << std::endl;
+        exit(1);
+    }
+    // every entry takes some bytes, so that larger counts can't fit in
+    // the file, and the layout doesn't overflow.
+    const Header& h = *header_;
+    if (h.num_vtree_nodes > size || h.max_var > size || h.num_nodes > size ||
+        h.num_elements > size || h.num_roots > size) {
+        std::cerr << "[error] " << name << " is truncated" << std::endl;
+        exit(1);
+    }
+    const Layout l = compute_layout(h);
+    if (l.total > size) {
+        std::cerr << "[error] " << name << " is truncated" << std::endl;
+        exit(1);
+    }
+    vtree_ = reinterpret_cast<const VTreeEntry*>(image + l.vtree);
+    var_position_ = reinterpret_cast<const int32_t*>(image + l.var_position);
+    node_vtree_ = reinterpret_cast<const int32_t*>(image + l.node_vtree);
+    node_literal_ = reinterpret_cast<const int32_t*>(image + l.node_literal);
+    node_offsets_ = reinterpret_cast<const uint64_t*>(image + l.node_offsets);
+    elements_ = reinterpret_cast<const Element*>(image + l.elements);
+    roots_ = reinterpret_cast<const int64_t*>(image + l.roots);
+    if (!is_valid()) {
+        std::cerr << "[error] " << name << " is corrupted" << std::endl;
+        exit(1);
+    }
+    root_info_.reset(new RootInfo[header_->num_roots]);
+}
+
+
+// one pass over the sections, so that queries never read out of them.
+bool FrozenZsdd::is_valid() const {
+    const Header& h = *header_;
+    const uint64_t num_vtree_nodes = h.num_vtree_nodes;
+    if (num_vtree_nodes == 0 || h.vtree_root >= num_vtree_nodes) return false;
+    const int32_t num_leaves = vtree_[h.vtree_root].leaf_end;
+    if (vtree_[h.vtree_root].leaf_begin != 0 || num_leaves <= 0) return false;
+    for (uint64_t i = 0; i < num_vtree_nodes; i++) {
+        const VTreeEntry& v = vtree_[i];
+        if (v.leaf_begin < 0 || v.leaf_begin >= v.leaf_end || v.leaf_end > num_leaves) return false;
+        if (v.left < 0) {
+            if (static_cast<uint64_t>(-static_cast<int64_t>(v.left)) > h.max_var) return false;
+        } else if (static_cast<uint64_t>(v.left) >= num_vtree_nodes ||
+                   v.right < 0 || static_cast<uint64_t>(v.right) >= num_vtree_nodes) {
+            return false;
+        }
+    }
+    for (uint64_t v = 0; v <= h.max_var; v++) {
+        if (var_position_[v] < -1 || var_position_[v] >= num_leaves) return false;
+    }
+    if (node_offsets_[0] != 0 || node_offsets_[h.num_nodes] != h.num_elements) return false;
+    for (uint64_t i = 0; i < h.num_nodes; i++) {
+        if (node_offsets_[i] > node_offsets_[i+1]) return false;
+    }
+    for (uint64_t i = 0; i < h.num_nodes; i++) {
+        if (node_vtree_[i] < 0 || static_cast<uint64_t>(node_vtree_[i]) >= num_vtree_nodes) return false;
+        const int32_t literal = node_literal_[i];
+        if (literal != 0 && (static_cast<uint64_t>(abs(literal)) > h.max_var ||
+                             var_position_[abs(literal)] < 0)) {
+            return false;
+        }
+        // literals are at the leaf of their variable without elements, and
+        // decompositions are at internal nodes with elements.
+        const VTreeEntry& v = vtree_[node_vtree_[i]];
+        if ((literal == 0) != (v.left >= 0)) return false;
+        if (literal != 0 && (-v.left != abs(literal) || node_offsets_[i] != node_offsets_[i+1])) {
+            return false;
+        }
+        if (literal == 0 && node_offsets_[i] == node_offsets_[i+1]) return false;
+        // children are earlier nodes.
+        for (uint64_t k = node_offsets_[i]; k < node_offsets_[i+1]; k++) {
+            const int64_t p = elements_[k].prime;
+            const int64_t s = elements_[k].sub;
+            if (p >= static_cast<int64_t>(i) || s >= static_cast<int64_t>(i) ||
+                p < ZSDD_FALSE || s < ZSDD_FALSE) {
+                return false;
+            }
+        }
+    }
+    for (uint64_t r = 0; r < h.num_roots; r++) {
+        if (roots_[r] < ZSDD_FALSE || roots_[r] >= static_cast<int64_t>(h.num_nodes)) return false;
+    }
+    return true;
+}
+
+
+const FrozenZsdd::RootInfo& FrozenZsdd::counted(const size_t root_index) const {
+    RootInfo& info = root_info_[root_index];
+    std::call_once(info.counted, [this, root_index, &info]() {
+            const size_t num_variables = (header_->num_vtree_nodes + 1) / 2;
+            const CountType type = exact_count_type(num_variables);
+            info.count = 0;
+            info.fits = count_models(info.count, root_index);
+            if (type == CountType::UINT64) {
+                info.exact_count = CountTraits<unsigned long long>::to_string(info.count);
+            }
+#ifdef ZSDD_HAS_INT128
+            else if (type == CountType::UINT128) {
+                uint128_t exact = 0;
+                count_models(exact, root_index);
+                info.exact_count = CountTraits<uint128_t>::to_string(exact);
+            }
+#endif
+            else {
+                BigInt exact;
+                count_models(exact, root_index);
+                info.exact_count = exact.to_string();
+            }
+
+            // the elements of the nodes reachable from the root, from the top.
+            const addr_t root = roots_[root_index];
+            info.size = 0;
+            if (root >= 0) {
+                std::vector<char> reachable(root + 1, 0);
+                reachable[root] = 1;
+                for (addr_t i = root; i >= 0; i--) {
+                    if (!reachable[i]) continue;
+                    info.size += node_offsets_[i+1] - node_offsets_[i];
+                    for (uint64_t k = node_offsets_[i]; k < node_offsets_[i+1]; k++) {
+                        if (elements_[k].prime >= 0) reachable[elements_[k].prime] = 1;
+                        if (elements_[k].sub >= 0) reachable[elements_[k].sub] = 1;
+                    }
+                }
+            }
+        });
+    return info;
+}
+
+
+unsigned long long FrozenZsdd::count_solution(const size_t root_index) const {
+    const RootInfo& info = counted(root_index);
+    if (!info.fits) {
+        std::cerr << "[error] model count overflows 64 bits (use count_solution_exact)" << std::endl;
+        exit(1);
+    }
+    return info.count;
+}
+
+
+std::string FrozenZsdd::count_consistent_exact(const std::vector<int>& literals,
+                                               const size_t root_index) const {
+    const size_t num_variables = (header_->num_vtree_nodes + 1) / 2;
+    switch (exact_count_type(num_variables)) {
+    case CountType::UINT64: {
+        unsigned long long count = 0;
+        count_consistent(literals, count, root_index);
+        return CountTraits<unsigned long long>::to_string(count);
+    }
+#ifdef ZSDD_HAS_INT128
+    case CountType::UINT128: {
+        uint128_t count = 0;
+        count_consistent(literals, count, root_index);
+        return CountTraits<uint128_t>::to_string(count);
+    }
+#endif
+    default: {
+        BigInt count;
+        count_consistent(literals, count, root_index);
+        return count.to_string();
+    }
+    }
+}
+
+
+double FrozenZsdd::weighted_count(const std::vector<double>& weights, const size_t root_index) const {
+    const addr_t root = roots_[root_index];
+    if (root == ZSDD_EMPTY || root == ZSDD_FALSE) {
+        return (root == ZSDD_EMPTY) ? 1.0 : 0.0;
+    }
+    std::vector<double> values(root + 1, 0.0);
+    auto value_of = [&values](const int64_t zsdd) -> double {
+        if (zsdd == ZSDD_EMPTY) return 1.0;
+        if (zsdd == ZSDD_FALSE) return 0.0;
+        return values[zsdd];
+    };
+    for (addr_t i = 0; i <= root; i++) {
+        const int literal = node_literal_[i];
+        if (literal != 0) {
+            if (static_cast<size_t>(abs(literal)) >= weights.size()) {
+                std::cerr << "[error] no weight for variable " << abs(literal) << std::endl;
+                exit(1);
+            }
+            const double w = weights[abs(literal)];
+            values[i] = literal > 0 ? w : 1.0 + w;
+            continue;
+        }
+        for (uint64_t k = node_offsets_[i]; k < node_offsets_[i+1]; k++) {
+            values[i] += value_of(elements_[k].prime) * value_of(elements_[k].sub);
+        }
+    }
+    return values[root];
+}
+
+
+bool FrozenZsdd::is_member(const std::vector<int>& set, const size_t root_index) const {
+    std::vector<int32_t> positions;
+    positions.reserve(set.size());
+    for (auto v : set) {
+        if (v <= 0 || static_cast<uint64_t>(v) > header_->max_var || var_position_[v] < 0) {
+            return false;
+        }
+        positions.push_back(var_position_[v]);
+    }
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    const VTreeEntry& r = vtree_[header_->vtree_root];
+    return is_member_inner(roots_[root_index], r.leaf_begin, r.leaf_end, positions);
+}
+
+
+bool FrozenZsdd::is_member_inner(const addr_t zsdd, const int32_t leaf_begin, const int32_t leaf_end,
+                                 const std::vector<int32_t>& positions) const {
+    if (zsdd == ZSDD_FALSE) return false;
+    const int32_t c = count_in_range(positions, leaf_begin, leaf_end);
+    if (zsdd == ZSDD_EMPTY) return c == 0;
+
+    // the variables outside of the node must not be in the set.
+    const VTreeEntry& v = vtree_[node_vtree_[zsdd]];
+    if (c != count_in_range(positions, v.leaf_begin, v.leaf_end)) return false;
+    if (node_literal_[zsdd] != 0) {
+        return node_literal_[zsdd] < 0 || c == 1;
+    }
+    const VTreeEntry& l = vtree_[v.left];
+    const VTreeEntry& r = vtree_[v.right];
+    for (uint64_t k = node_offsets_[zsdd]; k < node_offsets_[zsdd+1]; k++) {
+        // primes are disjoint, so that at most one prime matches.
+        if (is_member_inner(elements_[k].prime, l.leaf_begin, l.leaf_end, positions)) {
+            return is_member_inner(elements_[k].sub, r.leaf_begin, r.leaf_end, positions);
+        }
+    }
+    return false;
+}
+
+
+void FrozenZsdd::enumerate(const std::function<bool(const std::vector<int>&)>& visitor,
+                           const size_t root_index) const {
+    std::vector<addr_t> pending(1, roots_[root_index]);
+    std::vector<int> set;
+    enumerate_inner(pending, set, visitor);
+}
+
+
+bool FrozenZsdd::enumerate_inner(std::vector<addr_t>& pending, std::vector<int>& set,
+                                 const std::function<bool(const std::vector<int>&)>& visitor) const {
+    if (pending.empty()) return visitor(set);
+    const addr_t zsdd = pending.back();
+    pending.pop_back();
+    bool cont = true;
+    if (zsdd == ZSDD_EMPTY) {
+        cont = enumerate_inner(pending, set, visitor);
+    } else if (zsdd >= 0 && node_literal_[zsdd] != 0) {
+        const int literal = node_literal_[zsdd];
+        if (literal < 0) {
+            cont = enumerate_inner(pending, set, visitor);
+        }
+        if (cont) {
+            set.push_back(abs(literal));
+            cont = enumerate_inner(pending, set, visitor);
+            set.pop_back();
+        }
+    } else if (zsdd >= 0) {
+        for (uint64_t k = node_offsets_[zsdd]; cont && k < node_offsets_[zsdd+1]; k++) {
+            const Element& e = elements_[k];
+            if (e.prime == ZSDD_FALSE || e.sub == ZSDD_FALSE) continue;
+            pending.push_back(e.sub);
+            pending.push_back(e.prime);
+            cont = enumerate_inner(pending, set, visitor);
+            pending.pop_back();
+            pending.pop_back();
+        }
+    }
+    pending.push_back(zsdd);
+    return cont;
+}
+
+std::shared_ptr<const EvaluationOrder> FrozenZsdd::evaluation_order(const size_t root_index) const {
+    const addr_t root = roots_[root_index];
+    if (root < 0) {
+        std::cerr << "[error] evaluation order of a terminal" << std::endl;
+        exit(1);
+    }
+    std::shared_ptr<EvaluationOrder> order = std::make_shared<EvaluationOrder>();
+    // frozen nodes are already bottom-up, so that node i is at position i + 2.
+    auto position = [](const int64_t zsdd) -> size_t {
+        if (zsdd == ZSDD_FALSE) return 0;
+        if (zsdd == ZSDD_EMPTY) return 1;
+        return zsdd + 2;
+    };
+    order->nodes.resize(root + 1);
+    order->literals.assign(node_literal_, node_literal_ + root + 1);
+    order->offsets.assign(node_offsets_, node_offsets_ + root + 2);
+    order->elements.reserve(node_offsets_[root + 1]);
+    for (addr_t i = 0; i <= root; i++) {
+        order->nodes[i] = i;
+    }
+    for (uint64_t k = 0; k < node_offsets_[root + 1]; k++) {
+        order->elements.emplace_back(position(elements_[k].prime), position(elements_[k].sub));
+    }
+    return order;
+}
+
+const ZsddSampler& FrozenZsdd::sampler(const size_t root_index) const {
+    if (roots_[root_index] == ZSDD_FALSE) {
+        std::cerr << "[error] can't sample from the empty family" << std::endl;
+        exit(1);
+    }
+    RootInfo& info = root_info_[root_index];
+    std::call_once(info.sampled, [this, root_index, &info]() {
+            info.sampler.reset(new ZsddSampler(*this, root_index));
+        });
+    return *info.sampler;
+}
+
+
+void FrozenZsdd::sample(std::mt19937_64& rng, std::vector<int>& set, const size_t root_index) const {
+    sampler(root_index).sample(rng, set);
+}
+
+
+std::vector<std::vector<int>> FrozenZsdd::sample(const size_t num_samples, const uint64_t seed,
+                                                 const size_t root_index,
+                                                 const unsigned int num_threads) const {
+    return sampler(root_index).sample(num_samples, seed, num_threads);
+}
+
+} // namespace zsdd
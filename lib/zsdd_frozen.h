@@ -0,0 +1,253 @@
+#ifndef ZSDD_FROZEN_H_
+#define ZSDD_FROZEN_H_
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include "zsdd_common.h"
+#include "zsdd_count.h"
+#include "zsdd_mapped_file.h"
+
+namespace zsdd {
+
+class Zsdd;
+class ZsddManager;
+class ZsddSampler;
+struct EvaluationOrder;
+
+// immutable zsdds in a flat layout that is used directly from a
+// memory-mapped file. nodes are stored bottom-up, and node i has the
+// elements elements()[node_offsets()[i], node_offsets()[i+1]).
+// element references are node indices or ZSDD_EMPTY/ZSDD_FALSE.
+// all queries are const and can be called from any number of threads.
+// the counts, sizes and samplers of a root are computed at the first
+// query and kept, so that opening a file only checks it.
+class FrozenZsdd {
+public:
+    struct VTreeEntry {
+        int32_t left;   // -var for leaves
+        int32_t right;
+        int32_t parent;
+        int32_t leaf_begin; // the leaves of the subtree are
+        int32_t leaf_end;   // [leaf_begin, leaf_end) in dfs order.
+        int32_t reserved;
+    };
+    struct Element {
+        int64_t prime;
+        int64_t sub;
+    };
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t num_roots;
+        uint64_t num_vtree_nodes;
+        uint64_t vtree_root;
+        uint64_t max_var;
+        uint64_t num_nodes;
+        uint64_t num_elements;
+    };
+
+    explicit FrozenZsdd(const std::string& file_name);
+    // the frozen image of zsdds of mgr in memory. it doesn't refer to mgr
+    // after the construction.
+    FrozenZsdd(const ZsddManager& mgr, const std::vector<Zsdd>& zsdds);
+    FrozenZsdd(const FrozenZsdd& obj) = delete;
+    void operator=(const FrozenZsdd& obj) = delete;
+
+    // write zsdds of mgr to file_name in the frozen format.
+    static void write(const ZsddManager& mgr, const std::vector<Zsdd>& zsdds,
+                      const std::string& file_name);
+
+    size_t num_roots() const { return header_->num_roots; }
+    addr_t root(const size_t i) const { return roots_[i]; }
+    size_t num_nodes() const { return header_->num_nodes; }
+    size_t num_elements() const { return header_->num_elements; }
+    size_t max_var() const { return header_->max_var; }
+
+    // raw layout.
+    const VTreeEntry* vtree() const { return vtree_; }
+    const int32_t* node_vtree() const { return node_vtree_; }
+    const int32_t* node_literal() const { return node_literal_; } // 0 for decompositions
+    const uint64_t* node_offsets() const { return node_offsets_; }
+    const Element* elements() const { return elements_; }
+
+    // same as the counting and size of ZsddManager.
+    unsigned long long count_solution(const size_t root_index = 0) const;
+    const std::string& count_solution_exact(const size_t root_index = 0) const {
+        return counted(root_index).exact_count;
+    }
+    unsigned long long size(const size_t root_index = 0) const { return counted(root_index).size; }
+    // count the members in T. returns false on overflow.
+    template <typename T>
+    bool count_models(T& count, const size_t root_index = 0) const;
+    // the number of members consistent with a partial assignment: the
+    // variables of positive literals are in the member, and those of
+    // negative literals are not. returns false on overflow.
+    template <typename T>
+    bool count_consistent(const std::vector<int>& literals, T& count,
+                          const size_t root_index = 0) const;
+    std::string count_consistent_exact(const std::vector<int>& literals,
+                                       const size_t root_index = 0) const;
+    // the sum of the weights of the members, where a set weighs the
+    // product of weights[v] of its variables.
+    double weighted_count(const std::vector<double>& weights, const size_t root_index = 0) const;
+    // check whether the set of variables is a member of the family.
+    bool is_member(const std::vector<int>& set, const size_t root_index = 0) const;
+    // call visitor for every member. the enumeration stops
+    // when visitor returns false. the vector is reused between calls.
+    void enumerate(const std::function<bool(const std::vector<int>&)>& visitor,
+                   const size_t root_index = 0) const;
+    // uniform sampling as ZsddSampler. the family must not be empty.
+    void sample(std::mt19937_64& rng, std::vector<int>& set, const size_t root_index = 0) const;
+    std::vector<std::vector<int>> sample(const size_t num_samples, const uint64_t seed,
+                                         const size_t root_index = 0,
+                                         const unsigned int num_threads = 1) const;
+    // the nodes up to the root in the form of ZsddManager::evaluation_order,
+    // e.g., for ZsddSampler. the root must be a node.
+    std::shared_ptr<const EvaluationOrder> evaluation_order(const size_t root_index = 0) const;
+
+private:
+    MappedFile file_;
+    std::vector<uint64_t> image_; // the image built in memory
+    const Header* header_;
+    const VTreeEntry* vtree_;
+    const int32_t* var_position_;
+    const int32_t* node_vtree_;
+    const int32_t* node_literal_;
+    const uint64_t* node_offsets_;
+    const Element* elements_;
+    const int64_t* roots_;
+    // computed on demand, once per root.
+    struct RootInfo {
+        std::once_flag counted;
+        bool fits; // false if the count overflows 64 bits
+        unsigned long long count;
+        std::string exact_count;
+        unsigned long long size;
+        std::once_flag sampled;
+        std::shared_ptr<const ZsddSampler> sampler; // null for the empty family
+    };
+    std::unique_ptr<RootInfo[]> root_info_;
+
+    void setup(const char* image, const size_t size, const std::string& name);
+    bool is_valid() const;
+    const RootInfo& counted(const size_t root_index) const;
+    const ZsddSampler& sampler(const size_t root_index) const;
+    bool is_member_inner(const addr_t zsdd, const int32_t leaf_begin, const int32_t leaf_end,
+                         const std::vector<int32_t>& positions) const;
+    bool enumerate_inner(std::vector<addr_t>& pending, std::vector<int>& set,
+                         const std::function<bool(const std::vector<int>&)>& visitor) const;
+};
+
+
+template <typename T>
+bool FrozenZsdd::count_models(T& count, const size_t root_index) const {
+    typedef CountTraits<T> Traits;
+    const T zero = Traits::zero();
+    const T one = Traits::one();
+    const addr_t root = roots_[root_index];
+    if (root == ZSDD_EMPTY || root == ZSDD_FALSE) {
+        count = (root == ZSDD_EMPTY) ? one : zero;
+        return true;
+    }
+
+    // nodes are stored bottom-up, so that children are counted before parents.
+    std::vector<T> counts(root + 1, zero);
+    auto count_of = [&](const int64_t zsdd) -> const T& {
+        if (zsdd == ZSDD_EMPTY) return one;
+        if (zsdd == ZSDD_FALSE) return zero;
+        return counts[zsdd];
+    };
+    for (addr_t i = 0; i <= root; i++) {
+        if (node_literal_[i] != 0) {
+            counts[i] = node_literal_[i] < 0 ? Traits::two() : one;
+            continue;
+        }
+        for (uint64_t k = node_offsets_[i]; k < node_offsets_[i+1]; k++) {
+            if (!Traits::add_product(counts[i], count_of(elements_[k].prime),
+                                     count_of(elements_[k].sub))) {
+                return false;
+            }
+        }
+    }
+    count = counts[root];
+    return true;
+}
+
+
+// a node counts the consistent members over its own variables. a node
+// referred to in a wider scope has the other variables of the scope
+// absent, so that it counts only if none of them is forced in.
+template <typename T>
+bool FrozenZsdd::count_consistent(const std::vector<int>& literals, T& count,
+                                  const size_t root_index) const {
+    typedef CountTraits<T> Traits;
+    const T zero = Traits::zero();
+    const T one = Traits::one();
+    const VTreeEntry& r = vtree_[header_->vtree_root];
+    // forced_in[i] is the number of forced-in leaves among the first i.
+    std::vector<int32_t> forced_in(r.leaf_end + 1, 0);
+    std::vector<char> forced_out(r.leaf_end, 0);
+    for (auto l : literals) {
+        const int v = abs(l);
+        if (v == 0 || static_cast<uint64_t>(v) > header_->max_var || var_position_[v] < 0) {
+            // a variable out of the vtree is in no member.
+            if (l > 0) {
+                count = zero;
+                return true;
+            }
+            continue;
+        }
+        if (l > 0) {
+            forced_in[var_position_[v] + 1] = 1;
+        } else {
+            forced_out[var_position_[v]] = 1;
+        }
+    }
+    for (int32_t i = 0; i < r.leaf_end; i++) {
+        forced_in[i+1] += forced_in[i];
+    }
+    auto none_forced = [&forced_in](const int32_t begin, const int32_t end) {
+        return forced_in[end] == forced_in[begin];
+    };
+
+    const addr_t root = roots_[root_index];
+    std::vector<T> counts(root < 0 ? 0 : root + 1, zero);
+    auto count_in = [&](const int64_t zsdd, const VTreeEntry& scope) -> T {
+        if (zsdd == ZSDD_FALSE) return zero;
+        if (zsdd == ZSDD_EMPTY) return none_forced(scope.leaf_begin, scope.leaf_end) ? one : zero;
+        const VTreeEntry& v = vtree_[node_vtree_[zsdd]];
+        if (!none_forced(scope.leaf_begin, v.leaf_begin) || !none_forced(v.leaf_end, scope.leaf_end)) {
+            return zero;
+        }
+        return counts[zsdd];
+    };
+    for (addr_t i = 0; i <= root; i++) {
+        const int literal = node_literal_[i];
+        if (literal != 0) {
+            const int32_t p = var_position_[abs(literal)];
+            counts[i] = forced_out[p] ? zero : one;
+            if (literal < 0 && forced_in[p] == forced_in[p+1]) {
+                Traits::add_product(counts[i], one, one);
+            }
+            continue;
+        }
+        const VTreeEntry& v = vtree_[node_vtree_[i]];
+        for (uint64_t k = node_offsets_[i]; k < node_offsets_[i+1]; k++) {
+            const T p = count_in(elements_[k].prime, vtree_[v.left]);
+            if (p == zero) continue;
+            if (!Traits::add_product(counts[i], p, count_in(elements_[k].sub, vtree_[v.right]))) {
+                return false;
+            }
+        }
+    }
+    count = count_in(root, r);
+    return true;
+}
+
+} // namespace zsdd
+
+#endif // ZSDD_FROZEN_H_
@@ -0,0 +1,539 @@
+#include "zsdd_manager.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include "zsdd.h"
+#include "zsdd_mapped_file.h"
+
+namespace zsdd {
+
+namespace {
+
+// binary format (all integers are LEB128 varints unless noted):
+//   magic "ZSDB", version (1 byte)
+//   number of vtree nodes, then per vtree node in id order:
+//     leaf: 2*var, internal: 2*left+1 and right
+//   number of zsdd nodes, then per node in bottom-up order:
+//     literal: tag 0, vtree id, zigzag(literal)
+//     decomposition: tag 1, vtree id, number of elements, {prime sub}*
+//   number of roots, then the roots
+//   FNV-1a checksum of all the preceding bytes (8 bytes, little endian)
+// references to nodes are 0 for false, 1 for empty and otherwise
+// 1 + (index of the referring node - index of the referred node),
+// where the roots refer from index = number of nodes.
+const char MAGIC[4] = {'Z', 'S', 'D', 'B'};
+const unsigned char FORMAT_VERSION = 1;
+
+
+uint64_t fnv1a(const unsigned char* p, const size_t n) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+
+class BinaryWriter {
+public:
+    void put_byte(const unsigned char b) { buf_.push_back(b); }
+    void put_varint(uint64_t v) {
+        while (v >= 0x80) {
+            buf_.push_back(static_cast<unsigned char>(v | 0x80));
+            v >>= 7;
+        }
+        buf_.push_back(static_cast<unsigned char>(v));
+    }
+    void put_zigzag(const int64_t v) {
+        put_varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+    void put_u64(const uint64_t v) {
+        for (int i = 0; i < 8; i++) {
+            buf_.push_back(static_cast<unsigned char>(v >> (8 * i)));
+        }
+    }
+    const std::vector<unsigned char>& buffer() const { return buf_; }
+    std::vector<unsigned char> release() { return std::move(buf_); }
+private:
+    std::vector<unsigned char> buf_;
+};
+
+
+class BinaryReader {
+public:
+    BinaryReader(const unsigned char* begin, const unsigned char* end,
+                 const std::string& file_name) :
+        p_(begin), end_(end), file_name_(file_name) {}
+
+    unsigned char get_byte() {
+        if (p_ == end_) corrupted();
+        return *p_++;
+    }
+    uint64_t get_varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const unsigned char b = get_byte();
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) return v;
+        }
+        corrupted();
+        return 0;
+    }
+    int64_t get_zigzag() {
+        const uint64_t v = get_varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+    uint64_t get_u64() {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) {
+            v |= static_cast<uint64_t>(get_byte()) << (8 * i);
+        }
+        return v;
+    }
+
+    void corrupted() const {
+        std::cerr << "[error] " << file_name_ << " is not a valid zsdd binary file" << std::endl;
+        exit(1);
+    }
+
+private:
+    const unsigned char* p_;
+    const unsigned char* end_;
+    const std::string& file_name_;
+};
+
+
+// check the header and the checksum of size bytes at begin,
+// and return a reader positioned at the vtree.
+BinaryReader open_binary(const unsigned char* begin, const size_t size,
+                         const std::string& file_name) {
+    const size_t header_size = sizeof(MAGIC) + 1;
+    BinaryReader reader(begin, begin + size, file_name);
+    if (size < header_size + 8 ||
+        !std::equal(MAGIC, MAGIC + sizeof(MAGIC), reinterpret_cast<const char*>(begin))) {
+        reader.corrupted();
+    }
+    if (begin[sizeof(MAGIC)] != FORMAT_VERSION) {
+        std::cerr << "[error] unsupported zsdd binary version "
+                  << static_cast<int>(begin[sizeof(MAGIC)]) << " in " << file_name << std::endl;
+        exit(1);
+    }
+    const size_t body_size = size - 8;
+    BinaryReader tail(begin + body_size, begin + size, file_name);
+    if (fnv1a(begin, body_size) != tail.get_u64()) {
+        reader.corrupted();
+    }
+    BinaryReader res(begin + header_size, begin + body_size, file_name);
+    return res;
+}
+
+
+void open_mapped_file(MappedFile& file, const std::string& file_name) {
+    if (!file.open(file_name)) {
+        std::cerr << "can't read " << file_name << std::endl;
+        exit(1);
+    }
+}
+
+
+VTree read_vtree(BinaryReader& reader) {
+    const uint64_t num_nodes = reader.get_varint();
+    // lefts[i] holds the variable for leaves.
+    std::vector<int> lefts(num_nodes);
+    std::vector<int> rights(num_nodes, -1);
+    std::vector<int> parents(num_nodes, -1);
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        const uint64_t v = reader.get_varint();
+        if (v % 2 == 0) {
+            lefts[i] = static_cast<int>(v / 2);
+            if (lefts[i] == 0) reader.corrupted();
+        } else {
+            lefts[i] = static_cast<int>(v / 2);
+            rights[i] = static_cast<int>(reader.get_varint());
+            if (static_cast<uint64_t>(lefts[i]) >= num_nodes ||
+                static_cast<uint64_t>(rights[i]) >= num_nodes) {
+                reader.corrupted();
+            }
+            parents[lefts[i]] = i;
+            parents[rights[i]] = i;
+        }
+    }
+    std::vector<VTreeNode> vtree_nodes;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        if (rights[i] < 0) {
+            vtree_nodes.emplace_back(lefts[i], parents[i]);
+        } else {
+            vtree_nodes.emplace_back(lefts[i], rights[i], parents[i]);
+        }
+    }
+    return VTree(vtree_nodes);
+}
+
+
+// reads the text format of export_zsdd_txt through a fixed-size buffer.
+class TxtScanner {
+public:
+    explicit TxtScanner(std::istream& is) :
+        is_(is), buf_(1U << 16), p_(0), end_(0), line_(1) {}
+
+    // returns the first character of the next non-empty line, or -1 at the end.
+    int next_line_type() {
+        int c;
+        while ((c = peek()) == ' ' || c == '\t' || c == '\r' || c == '\n') get();
+        if (c >= 0) get();
+        return c;
+    }
+    void skip_line() {
+        int c;
+        while ((c = peek()) >= 0 && c != '\n') get();
+    }
+    long long read_int() {
+        int c;
+        while ((c = peek()) == ' ' || c == '\t') get();
+        bool negative = false;
+        if (c == '-') {
+            negative = true;
+            get();
+        }
+        if (!(peek() >= '0' && peek() <= '9')) error();
+        long long v = 0;
+        while ((c = peek()) >= '0' && c <= '9') {
+            v = v * 10 + (c - '0');
+            get();
+        }
+        return negative ? -v : v;
+    }
+    void error() const {
+        std::cerr << "[error] invalid zsdd text at line " << line_ << std::endl;
+        exit(1);
+    }
+
+private:
+    std::istream& is_;
+    std::vector<char> buf_;
+    size_t p_;
+    size_t end_;
+    size_t line_;
+
+    int peek() {
+        if (p_ == end_) {
+            is_.read(buf_.data(), buf_.size());
+            end_ = is_.gcount();
+            p_ = 0;
+            if (end_ == 0) return -1;
+        }
+        return static_cast<unsigned char>(buf_[p_]);
+    }
+    void get() {
+        if (buf_[p_++] == '\n') line_++;
+    }
+};
+
+} // namespace
+
+
+void ZsddManager::save(const Zsdd& zsdd, const std::string& file_name) const {
+    save(std::vector<Zsdd>(1, zsdd), file_name);
+}
+
+
+void ZsddManager::save(const std::vector<Zsdd>& zsdds, const std::string& file_name) const {
+    const std::vector<unsigned char> buf = serialize(zsdds);
+    std::ofstream ofs(file_name, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    if (!ofs) {
+        std::cerr << "[error] can't write " << file_name << std::endl;
+        exit(1);
+    }
+}
+
+
+std::vector<unsigned char> ZsddManager::serialize(const std::vector<Zsdd>& zsdds) const {
+    BinaryWriter writer;
+    for (auto c : MAGIC) writer.put_byte(c);
+    writer.put_byte(FORMAT_VERSION);
+
+    writer.put_varint(vtree_.size());
+    for (size_t i = 0; i < vtree_.size(); i++) {
+        const VTreeNode& v = vtree_.get_node(i);
+        if (v.is_leaf()) {
+            writer.put_varint(2 * static_cast<uint64_t>(v.var()));
+        } else {
+            writer.put_varint(2 * static_cast<uint64_t>(v.left_child()) + 1);
+            writer.put_varint(v.right_child());
+        }
+    }
+
+    std::vector<addr_t> roots;
+    for (const auto& z : zsdds) {
+        roots.push_back(z.addr());
+    }
+    const std::vector<addr_t> nodes = collect_nodes_bottom_up(roots);
+    std::unordered_map<addr_t, uint64_t> index;
+    index.reserve(nodes.size());
+    auto ref = [&index](const addr_t zsdd, const uint64_t from) -> uint64_t {
+        if (zsdd == ZSDD_FALSE) return 0;
+        if (zsdd == ZSDD_EMPTY) return 1;
+        return 1 + from - index.at(zsdd);
+    };
+
+    writer.put_varint(nodes.size());
+    for (uint64_t i = 0; i < nodes.size(); i++) {
+        const ZsddNode& n = get_zsddnode_at(nodes[i]);
+        if (n.type() == NodeType::LIT) {
+            writer.put_byte(0);
+            writer.put_varint(n.vtree_node_id());
+            writer.put_zigzag(n.literal());
+        } else {
+            writer.put_byte(1);
+            writer.put_varint(n.vtree_node_id());
+            writer.put_varint(n.decomposition().size());
+            for (const auto& e : n.decomposition()) {
+                writer.put_varint(ref(e.first, i));
+                writer.put_varint(ref(e.second, i));
+            }
+        }
+        index.emplace(nodes[i], i);
+    }
+    writer.put_varint(roots.size());
+    for (const auto r : roots) {
+        writer.put_varint(ref(r, nodes.size()));
+    }
+    const auto& buf = writer.buffer();
+    writer.put_u64(fnv1a(buf.data(), buf.size()));
+    return writer.release();
+}
+
+
+Zsdd ZsddManager::load(const std::string& file_name) {
+    std::vector<Zsdd> zsdds = load_all(file_name);
+    if (zsdds.size() != 1) {
+        std::cerr << "[error] " << file_name << " holds " << zsdds.size()
+                  << " zsdds" << std::endl;
+        exit(1);
+    }
+    return zsdds[0];
+}
+
+
+std::vector<Zsdd> ZsddManager::load_all(const std::string& file_name) {
+    MappedFile file;
+    open_mapped_file(file, file_name);
+    return deserialize(reinterpret_cast<const unsigned char*>(file.data()), file.size(), file_name);
+}
+
+
+std::vector<Zsdd> ZsddManager::deserialize(const unsigned char* data, const size_t size,
+                                           const std::string& file_name) {
+    BinaryReader reader = open_binary(data, size, file_name);
+    if (read_vtree(reader) != vtree_) {
+        std::cerr << "[error] the vtree of " << file_name
+                  << " differs from the vtree of the manager" << std::endl;
+        exit(1);
+    }
+
+    const uint64_t num_nodes = reader.get_varint();
+    std::vector<addr_t> addrs;
+    addrs.reserve(num_nodes);
+    auto deref = [&addrs, &reader](const uint64_t ref) -> addr_t {
+        if (ref == 0) return ZSDD_FALSE;
+        if (ref == 1) return ZSDD_EMPTY;
+        if (ref - 1 > addrs.size()) reader.corrupted();
+        return addrs[addrs.size() - (ref - 1)];
+    };
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        const unsigned char tag = reader.get_byte();
+        const uint64_t vtree_node = reader.get_varint();
+        if (vtree_node >= vtree_.size()) reader.corrupted();
+        const VTreeNode& v = vtree_.get_node(vtree_node);
+        if (tag == 0) {
+            const int64_t literal = reader.get_zigzag();
+            if (!v.is_leaf() || llabs(literal) != v.var()) reader.corrupted();
+            addrs.push_back(zsdd_node_table_.make_or_find_literal(literal, vtree_node));
+        } else if (tag == 1) {
+            if (v.is_leaf()) reader.corrupted();
+            const uint64_t num_elements = reader.get_varint();
+            std::vector<ZsddElement> decomp;
+            decomp.reserve(num_elements);
+            for (uint64_t k = 0; k < num_elements; k++) {
+                const addr_t p = deref(reader.get_varint());
+                const addr_t s = deref(reader.get_varint());
+                // primes (subs) must be in the left (right) subtree.
+                if ((p >= 0 && !vtree_.is_left_descendant(vtree_node, get_zsddnode_at(p).vtree_node_id())) ||
+                    (s >= 0 && !vtree_.is_right_descendant(vtree_node, get_zsddnode_at(s).vtree_node_id()))) {
+                    reader.corrupted();
+                }
+                decomp.emplace_back(p, s);
+            }
+            if (decomp.empty()) reader.corrupted();
+            addrs.push_back(make_zsdd_decomposition(std::move(decomp), vtree_node));
+        } else {
+            reader.corrupted();
+        }
+    }
+    const uint64_t num_roots = reader.get_varint();
+    std::vector<Zsdd> res;
+    for (uint64_t i = 0; i < num_roots; i++) {
+        res.push_back(Zsdd(deref(reader.get_varint()), *this));
+    }
+    return res;
+}
+
+
+VTree ZsddManager::load_vtree(const std::string& file_name) {
+    MappedFile file;
+    open_mapped_file(file, file_name);
+    BinaryReader reader = open_binary(reinterpret_cast<const unsigned char*>(file.data()),
+                                      file.size(), file_name);
+    return read_vtree(reader);
+}
+
+
+Zsdd ZsddManager::import_from(const ZsddManager& src, const Zsdd& zsdd) {
+    return import_from(src, std::vector<Zsdd>(1, zsdd))[0];
+}
+
+
+std::vector<Zsdd> ZsddManager::import_from(const ZsddManager& src, const std::vector<Zsdd>& zsdds) {
+    if (&src == this) return zsdds;
+    // vtree ids of src to ids of this manager.
+    std::vector<int> vtree_ids(src.vtree().size());
+    if (src.vtree() == vtree_) {
+        for (size_t i = 0; i < vtree_ids.size(); i++) vtree_ids[i] = i;
+    } else {
+        if (src.vtree().size() != vtree_.size()) {
+            std::cerr << "[error] the vtrees of the managers are not isomorphic" << std::endl;
+            exit(1);
+        }
+        std::vector<std::pair<int, int>> stack(1, std::make_pair(src.vtree().root(), vtree_.root()));
+        while (!stack.empty()) {
+            const auto ids = stack.back();
+            stack.pop_back();
+            const VTreeNode& s = src.vtree().get_node(ids.first);
+            const VTreeNode& d = vtree_.get_node(ids.second);
+            if (s.is_leaf() != d.is_leaf() || (s.is_leaf() && s.var() != d.var())) {
+                std::cerr << "[error] the vtrees of the managers are not isomorphic" << std::endl;
+                exit(1);
+            }
+            vtree_ids[ids.first] = ids.second;
+            if (!s.is_leaf()) {
+                stack.emplace_back(s.left_child(), d.left_child());
+                stack.emplace_back(s.right_child(), d.right_child());
+            }
+        }
+    }
+
+    std::vector<addr_t> roots;
+    roots.reserve(zsdds.size());
+    for (const auto& z : zsdds) {
+        roots.push_back(z.addr());
+    }
+    std::unordered_map<addr_t, addr_t> addrs;
+    auto deref = [&addrs](const addr_t zsdd) -> addr_t {
+        return zsdd < 0 ? zsdd : addrs.at(zsdd);
+    };
+    for (const auto a : src.collect_nodes_bottom_up(roots)) {
+        const ZsddNode& n = src.get_zsddnode_at(a);
+        const int v = vtree_ids[n.vtree_node_id()];
+        if (n.type() == NodeType::LIT) {
+            addrs.emplace(a, zsdd_node_table_.make_or_find_literal(n.literal(), v));
+        } else {
+            std::vector<ZsddElement> decomp;
+            decomp.reserve(n.decomposition().size());
+            for (const auto& e : n.decomposition()) {
+                decomp.emplace_back(deref(e.first), deref(e.second));
+            }
+            addrs.emplace(a, make_zsdd_decomposition(std::move(decomp), v));
+        }
+    }
+    std::vector<Zsdd> res;
+    res.reserve(zsdds.size());
+    for (const auto r : roots) {
+        res.push_back(Zsdd(deref(r), *this));
+    }
+    return res;
+}
+
+
+Zsdd ZsddManager::import_zsdd_txt(std::istream& is) {
+    TxtScanner scanner(is);
+    // file ids to addresses.
+    std::vector<addr_t> addrs;
+    auto define = [&addrs, &scanner](const long long id, const addr_t addr) {
+        if (id < 0) scanner.error();
+        if (static_cast<size_t>(id) >= addrs.size()) {
+            addrs.resize(std::max(static_cast<size_t>(id) + 1, 2 * addrs.size()), ZSDD_NULL);
+        }
+        addrs[id] = addr;
+    };
+    auto lookup = [&addrs, &scanner](const long long id) -> addr_t {
+        if (id < 0 || static_cast<size_t>(id) >= addrs.size() || addrs[id] == ZSDD_NULL) {
+            scanner.error();
+        }
+        return addrs[id];
+    };
+    auto vtree_of = [this](const addr_t zsdd) -> int {
+        return zsdd < 0 ? -1 : get_zsddnode_at(zsdd).vtree_node_id();
+    };
+
+    addr_t root = ZSDD_NULL;
+    addr_t constant_root = ZSDD_NULL;
+    int type;
+    while ((type = scanner.next_line_type()) >= 0) {
+        if (type == 'c' || type == 'z') {
+            scanner.skip_line();
+        } else if (type == 'E' || type == 'F') {
+            constant_root = (type == 'E') ? ZSDD_EMPTY : ZSDD_FALSE;
+            define(scanner.read_int(), constant_root);
+        } else if (type == 'L') {
+            const long long id = scanner.read_int();
+            const long long v = scanner.read_int();
+            const long long literal = scanner.read_int();
+            if (v < 0 || v >= static_cast<long long>(vtree_.size()) ||
+                !vtree_.get_node(v).is_leaf() || vtree_.get_node(v).var() != llabs(literal)) {
+                std::cerr << "[error] literal " << literal << " does not match vtree node "
+                          << v << std::endl;
+                exit(1);
+            }
+            root = zsdd_node_table_.make_or_find_literal(literal, v);
+            define(id, root);
+        } else if (type == 'D') {
+            const long long id = scanner.read_int();
+            const long long v = scanner.read_int();
+            const long long num_elements = scanner.read_int();
+            if (v < 0 || v >= static_cast<long long>(vtree_.size()) ||
+                vtree_.get_node(v).is_leaf() || num_elements <= 0) {
+                std::cerr << "[error] decomposition " << id << " does not match vtree node "
+                          << v << std::endl;
+                exit(1);
+            }
+            std::vector<ZsddElement> decomp;
+            decomp.reserve(num_elements);
+            for (long long i = 0; i < num_elements; i++) {
+                const addr_t p = lookup(scanner.read_int());
+                const addr_t s = lookup(scanner.read_int());
+                if ((p >= 0 && !vtree_.is_left_descendant(v, vtree_of(p))) ||
+                    (s >= 0 && !vtree_.is_right_descendant(v, vtree_of(s)))) {
+                    std::cerr << "[error] decomposition " << id << " does not respect vtree node "
+                              << v << std::endl;
+                    exit(1);
+                }
+                decomp.emplace_back(p, s);
+            }
+            root = make_zsdd_decomposition(std::move(decomp), v);
+            define(id, root);
+        } else {
+            scanner.error();
+        }
+    }
+    if (root == ZSDD_NULL) root = constant_root;
+    if (root == ZSDD_NULL) scanner.error();
+    return Zsdd(root, *this);
+}
+
+} // namespace zsdd
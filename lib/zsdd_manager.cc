@@ -6,6 +6,9 @@
 #include <sstream>
 #include <string>
 #include "zsdd.h"
+#include "zsdd_count.h"
+#include "zsdd_enumerator.h"
+#include "zsdd_evaluate.h"
 
 namespace zsdd {
 
@@ -34,6 +37,11 @@ Zsdd ZsddManager::make_zsdd_empty() {
 void ZsddManager::gc() {
     zsdd_node_table_.gc();
     cache_table_.clear_cache();
+    // the ids are only referred to by the cache.
+    variable_set_ids_.clear();
+    std::lock_guard<std::mutex> lock(evaluation_orders_mutex_);
+    evaluation_orders_.clear();
+    evaluation_order_lru_.clear();
 }
 
 
@@ -234,6 +242,76 @@ addr_t ZsddManager::zsdd_apply_withvar(const Operation& op, const addr_t zsdd, c
 }
 
 
+int ZsddManager::align_decompositions(const addr_t lhs, const addr_t rhs,
+                                      std::vector<ZsddElement>& decomp_l,
+                                      std::vector<ZsddElement>& decomp_r) const {
+    int depend_vtree_node_id;
+    if (lhs < 0) {
+        assert(lhs == ZSDD_EMPTY);
+
+        const ZsddNode& n = get_zsddnode_at(rhs);
+        depend_vtree_node_id = n.vtree_node_id();
+        decomp_l = {{ZSDD_EMPTY, ZSDD_EMPTY}};
+        decomp_r = n.decomposition();
+    } 
+    else if (rhs < 0) {
+        assert(rhs == ZSDD_EMPTY);
+        
+        const ZsddNode& n = get_zsddnode_at(lhs);
+        depend_vtree_node_id = n.vtree_node_id();
+        decomp_l = n.decomposition();
+        decomp_r = {{ZSDD_EMPTY, ZSDD_EMPTY}};
+    }
+    else {
+        const ZsddNode& l_node = get_zsddnode_at(lhs);
+        const ZsddNode& r_node = get_zsddnode_at(rhs);
+
+        const addr_t l_vnode = l_node.vtree_node_id();
+        const addr_t r_vnode = r_node.vtree_node_id();
+        depend_vtree_node_id = vtree_.get_depend_node(l_vnode, r_vnode);
+        if (l_vnode == r_vnode) {
+            decomp_l = l_node.decomposition();
+            decomp_r = r_node.decomposition();
+        }
+        else if (l_vnode == depend_vtree_node_id) {
+            if (vtree_.is_left_descendant(depend_vtree_node_id, r_vnode)) {
+                decomp_l = l_node.decomposition();                
+                decomp_r = {{rhs, ZSDD_EMPTY}};
+            }  else {
+                decomp_l = l_node.decomposition();
+                decomp_r = {{ZSDD_EMPTY, rhs}};
+            }
+        }
+        else if (r_vnode == depend_vtree_node_id) {
+
+            if (vtree_.is_left_descendant(depend_vtree_node_id, l_vnode)) {
+                decomp_l = {{lhs, ZSDD_EMPTY}};
+                decomp_r = r_node.decomposition();
+
+            }  else {
+                decomp_l = {{ZSDD_EMPTY, lhs}};
+                decomp_r = r_node.decomposition();
+
+                
+            }
+        }
+        else { //depend node is a common ancestor
+            if (vtree_.is_left_descendant(depend_vtree_node_id, l_vnode)) {
+                decomp_l = {{lhs, ZSDD_EMPTY}};
+                decomp_r = {{ZSDD_EMPTY, rhs}};
+
+                
+            } else {
+                decomp_l = {{ZSDD_EMPTY, lhs}};
+                decomp_r = {{rhs, ZSDD_EMPTY}};
+
+            }
+        }
+    }
+    return depend_vtree_node_id;
+}
+
+
 addr_t ZsddManager::zsdd_apply(const Operation& op, const addr_t lhs, const addr_t rhs) {
     if (op == Operation::INTERSECTION || 
         op == Operation::UNION || 
@@ -395,69 +473,7 @@ addr_t ZsddManager::zsdd_apply(const Operation& op, const addr_t lhs, const addr
     // setup decomposition nodes;
     std::vector<ZsddElement> decomp_l;
     std::vector<ZsddElement> decomp_r;
-    addr_t depend_vtree_node_id;
-    if (lhs < 0) {
-        assert(lhs == ZSDD_EMPTY);
-
-        const ZsddNode& n = get_zsddnode_at(rhs);
-        depend_vtree_node_id = n.vtree_node_id();
-        decomp_l = {{ZSDD_EMPTY, ZSDD_EMPTY}};
-        decomp_r = n.decomposition();
-    } 
-    else if (rhs < 0) {
-        assert(rhs == ZSDD_EMPTY);
-        
-        const ZsddNode& n = get_zsddnode_at(lhs);
-        depend_vtree_node_id = n.vtree_node_id();
-        decomp_l = n.decomposition();
-        decomp_r = {{ZSDD_EMPTY, ZSDD_EMPTY}};
-    }
-    else {
-        const ZsddNode& l_node = get_zsddnode_at(lhs);
-        const ZsddNode& r_node = get_zsddnode_at(rhs);
-
-        const addr_t l_vnode = l_node.vtree_node_id();
-        const addr_t r_vnode = r_node.vtree_node_id();
-        depend_vtree_node_id = vtree_.get_depend_node(l_vnode, r_vnode);
-        if (l_vnode == r_vnode) {
-            decomp_l = l_node.decomposition();
-            decomp_r = r_node.decomposition();
-        }
-        else if (l_vnode == depend_vtree_node_id) {
-            if (vtree_.is_left_descendant(depend_vtree_node_id, r_vnode)) {
-                decomp_l = l_node.decomposition();                
-                decomp_r = {{rhs, ZSDD_EMPTY}};
-            }  else {
-                decomp_l = l_node.decomposition();
-                decomp_r = {{ZSDD_EMPTY, rhs}};
-            }
-        }
-        else if (r_vnode == depend_vtree_node_id) {
-
-            if (vtree_.is_left_descendant(depend_vtree_node_id, l_vnode)) {
-                decomp_l = {{lhs, ZSDD_EMPTY}};
-                decomp_r = r_node.decomposition();
-
-            }  else {
-                decomp_l = {{ZSDD_EMPTY, lhs}};
-                decomp_r = r_node.decomposition();
-
-                
-            }
-        }
-        else { //depend node is a common ancestor
-            if (vtree_.is_left_descendant(depend_vtree_node_id, l_vnode)) {
-                decomp_l = {{lhs, ZSDD_EMPTY}};
-                decomp_r = {{ZSDD_EMPTY, rhs}};
-
-                
-            } else {
-                decomp_l = {{ZSDD_EMPTY, lhs}};
-                decomp_r = {{rhs, ZSDD_EMPTY}};
-
-            }
-        }
-    }
+    const addr_t depend_vtree_node_id = align_decompositions(lhs, rhs, decomp_l, decomp_r);
     
     std::vector<std::pair<addr_t, addr_t>> new_decomp_candidates;
     if (op == Operation::ORTHOGONAL_JOIN) {
@@ -569,88 +585,59 @@ std::vector<ZsddElement> ZsddManager::compress_candidates(const std::vector<std:
 
 
 unsigned long long ZsddManager::count_solution(const addr_t zsdd) const {
-    std::unordered_map<addr_t, unsigned long long> cache;
-    return count_solution_inner(zsdd, cache);
+    unsigned long long count = 0;
+    if (!count_models(*this, zsdd, count)) {
+        std::cerr << "[error] model count overflows 64 bits (use count_solution_exact)" << std::endl;
+        exit(1);
+    }
+    return count;
 }
 
 
-unsigned long long ZsddManager::count_solution_inner(const addr_t zsdd, 
-                                                     std::unordered_map<addr_t, 
-                                                     unsigned long long>& cache) const {
-    if (zsdd == ZSDD_EMPTY) return 1LLU;
-    if (zsdd == ZSDD_FALSE) return 0LLU;
-
-    auto r = cache.find(zsdd);
-    if (r != cache.end()) {
-        return r->second;
+std::string ZsddManager::count_solution_exact(const addr_t zsdd) const {
+    const size_t num_variables = (vtree_.size() + 1) / 2;
+    switch (exact_count_type(num_variables)) {
+    case CountType::UINT64: {
+        unsigned long long count = 0;
+        count_models(*this, zsdd, count);
+        return CountTraits<unsigned long long>::to_string(count);
     }
-    
-    const ZsddNode& n = get_zsddnode_at(zsdd);
-    if (n.type() == NodeType::LIT) {
-        if (n.literal() < 0) {
-            cache.emplace(zsdd, 2LLU);
-            return 2LLU;
-        } else {
-            cache.emplace(zsdd, 1LLU);
-            return 1LLU;
-        }
+#ifdef ZSDD_HAS_INT128
+    case CountType::UINT128: {
+        uint128_t count = 0;
+        count_models(*this, zsdd, count);
+        return CountTraits<uint128_t>::to_string(count);
+    }
+#endif
+    default: {
+        BigInt count;
+        count_models(*this, zsdd, count);
+        return count.to_string();
     }
-    else { // n.type() == NodeType::DECOMP
-        unsigned long long c = 0LLU;
-        for (const auto e : n.decomposition()) {
-            auto p_c = count_solution_inner(e.first, cache);
-            auto s_c = count_solution_inner(e.second, cache);
-            c += p_c * s_c;
-        }
-        cache.emplace(zsdd, c);
-        return c;
     }
 }
 
 
-std::vector<std::vector<int>> ZsddManager::calc_setfamily(const addr_t zsdd) const {
-    std::unordered_map<addr_t, std::vector<std::vector<int>>> cache;
-    return calc_setfamily_inner(zsdd, cache);
+double ZsddManager::count_solution_log2(const addr_t zsdd) const {
+    LogCount count = CountTraits<LogCount>::zero();
+    count_models(*this, zsdd, count);
+    return count.log2;
 }
 
-std::vector<std::vector<int>> 
-ZsddManager::calc_setfamily_inner(const addr_t zsdd, 
-                                  std::unordered_map<addr_t, std::vector<std::vector<int>>>& cache) const {
-    if (zsdd == ZSDD_EMPTY) return std::vector<std::vector<int>>(1, std::vector<int>());
-    if (zsdd == ZSDD_FALSE) return std::vector<std::vector<int>>();
 
-    auto r = cache.find(zsdd);
-    if (r != cache.end()) {
-        return r->second;
-    }
+std::vector<std::vector<int>> ZsddManager::calc_setfamily(const addr_t zsdd) const {
+    std::vector<std::vector<int>> res;
+    enumerate(*this, zsdd, [&res](const std::vector<int>& set) {
+            res.push_back(set);
+            return true;
+        });
+    return res;
+}
 
-    const ZsddNode& n = get_zsddnode_at(zsdd);
-    std::vector<std::vector<int>> v;
-    if (n.type() == NodeType::LIT) {
-        if (n.literal() < 0) {
-            v.push_back(std::vector<int>());
-            v.push_back({-n.literal()});
-        } else {
-            v.push_back({n.literal()});
-        }
-    }
-    else { // n.type() == NodeType::DECOMP
-        for (const auto e : n.decomposition()) {
-            const auto& p_v = calc_setfamily_inner(e.first, cache);
-            const auto& s_v = calc_setfamily_inner(e.second, cache);
 
-            for (const auto& x : p_v) {
-                for (const auto& y : s_v) {
-                    auto z = x;
-                    z.insert(z.end(), y.begin(), y.end());
-                    v.emplace_back(move(z));
-                }
-            }
-        }
-    }
-    cache.emplace(zsdd, v);
-    return v;
-    
+Zsdd ZsddManager::make_zsdd_powerset(const int vtree_node) {
+    addr_t res = make_zsdd_powerset_inner(vtree_node);
+    return Zsdd(res, *this);
 }
 
 
@@ -676,41 +663,85 @@ addr_t ZsddManager::make_zsdd_powerset_inner(const int vtree_node) {
 
 unsigned long long int ZsddManager::size(const addr_t zsdd) const {
     if (zsdd < 0) return 0;
-    
-    std::unordered_set<addr_t> nodes;
-    std::stack<addr_t> unexpanded;
-    unexpanded.push(zsdd);
-    while (!unexpanded.empty()) {
-        addr_t e = unexpanded.top();
-        unexpanded.pop();
-
-        nodes.insert(e);
-        if (e < 0) {
-            continue;
-        }                
-        const ZsddNode& n = zsdd_node_table_.get_node_at(e);
-        if (n.type() == NodeType::DECOMP) {
-            for (const ZsddElement e : n.decomposition()) {
-                if (nodes.find(e.first) == nodes.end()) {
-                    nodes.insert(e.first);
-                    unexpanded.push(e.first);
-                }
-                if (nodes.find(e.second) == nodes.end()) {
-                    nodes.insert(e.second);
-                    unexpanded.push(e.second);
+    return evaluation_order(zsdd)->elements.size();
+}
+
+
+std::vector<addr_t> ZsddManager::collect_nodes_bottom_up(const std::vector<addr_t>& roots) const {
+    std::vector<addr_t> order;
+    std::unordered_set<addr_t> visited;
+    // (node, index of the next child to visit)
+    std::stack<std::pair<addr_t, size_t>> unexpanded;
+    for (const auto root : roots) {
+        if (root < 0 || !visited.insert(root).second) continue;
+        unexpanded.emplace(root, 0);
+        while (!unexpanded.empty()) {
+            auto& top = unexpanded.top();
+            const auto& decomp = get_zsddnode_at(top.first).decomposition();
+            if (top.second < 2 * decomp.size()) {
+                const ZsddElement& e = decomp[top.second / 2];
+                const addr_t child = (top.second % 2 == 0) ? e.first : e.second;
+                top.second++;
+                if (child >= 0 && visited.insert(child).second) {
+                    unexpanded.emplace(child, 0);
                 }
+            } else {
+                order.push_back(top.first);
+                unexpanded.pop();
             }
         }
     }
-    unsigned long long int size = 0LLU;
-    for (const auto i : nodes) {
-        if (i < 0) continue;
-        const ZsddNode& n = get_zsddnode_at(i);
-        if (n.type() == NodeType::DECOMP) {
-            size += n.decomposition().size();
-        }
-    }
-    return size;
+    return order;
+}
+
+
+std::shared_ptr<const EvaluationOrder> ZsddManager::evaluation_order(const addr_t zsdd) const {
+    {
+        std::lock_guard<std::mutex> lock(evaluation_orders_mutex_);
+        auto r = evaluation_orders_.find(zsdd);
+        if (r != evaluation_orders_.end()) {
+            evaluation_order_lru_.splice(evaluation_order_lru_.begin(), evaluation_order_lru_, r->second);
+            return r->second->second;
+        }
+    }
+
+    // the order is built without the lock, since it only reads the nodes.
+    std::shared_ptr<EvaluationOrder> order = std::make_shared<EvaluationOrder>();
+    order->nodes = collect_nodes_bottom_up(std::vector<addr_t>(1, zsdd));
+    std::unordered_map<addr_t, size_t> position;
+    position.reserve(order->nodes.size());
+    auto position_of = [&position](const addr_t z) -> size_t {
+        if (z == ZSDD_FALSE) return 0;
+        if (z == ZSDD_EMPTY) return 1;
+        return position.at(z);
+    };
+    order->literals.reserve(order->nodes.size());
+    order->offsets.reserve(order->nodes.size() + 1);
+    for (size_t i = 0; i < order->nodes.size(); i++) {
+        const ZsddNode& n = get_zsddnode_at(order->nodes[i]);
+        order->literals.push_back(n.type() == NodeType::LIT ? n.literal() : 0);
+        order->offsets.push_back(order->elements.size());
+        for (const auto& e : n.decomposition()) {
+            order->elements.emplace_back(position_of(e.first), position_of(e.second));
+        }
+        position.emplace(order->nodes[i], i + 2);
+    }
+    order->offsets.push_back(order->elements.size());
+
+    std::lock_guard<std::mutex> lock(evaluation_orders_mutex_);
+    // another thread may have built the same order.
+    auto r = evaluation_orders_.find(zsdd);
+    if (r != evaluation_orders_.end()) {
+        return r->second->second;
+    }
+    evaluation_order_lru_.emplace_front(zsdd, order);
+    evaluation_orders_.emplace(zsdd, evaluation_order_lru_.begin());
+    // keep the cache small when many roots are evaluated.
+    if (evaluation_order_lru_.size() > MAX_EVALUATION_ORDERS) {
+        evaluation_orders_.erase(evaluation_order_lru_.back().first);
+        evaluation_order_lru_.pop_back();
+    }
+    return order;
 }
 
 
@@ -722,7 +753,8 @@ Zsdd ZsddManager::zsdd_to_explicit_form(const Zsdd& zsdd) {
 
 addr_t ZsddManager::zsdd_to_explicit_form_inner(const addr_t zsdd) {
     if (zsdd < 0) return zsdd;
-    ZsddNode& n = get_zsddnode_at(zsdd);
+    // copy the node, since new nodes may reallocate the node table.
+    const ZsddNode n = get_zsddnode_at(zsdd);
     if (n.type() == NodeType::LIT) return zsdd;
 
     {
@@ -759,7 +791,7 @@ void  ZsddManager::export_zsdd_txt_inner(const addr_t zsdd, std::ostream& os,
     assert(node.type() != NodeType::UNUSED);
     if (node.type() == NodeType::LIT) {
         os << "L " << zsdd << " " << node.vtree_node_id() 
-           << " " << node.literal() << std::endl;
+           << " " << node.literal() << "\n";
         return;
     }
     
@@ -785,7 +817,7 @@ void  ZsddManager::export_zsdd_txt_inner(const addr_t zsdd, std::ostream& os,
         addr_t s = func(e.second);
         os << " " << p << " " << s;
     }
-    os << std::endl;
+    os << "\n";
 }
 
 void  ZsddManager::export_zsdd_txt(const addr_t zsdd, std::ostream& os) const {
@@ -805,18 +837,18 @@ void  ZsddManager::export_zsdd_txt(const addr_t zsdd, std::ostream& os) const {
         "c D id-of-decomposition-sdd-node id-of-vtree number-of-elements {id-of-prime id-of-sub}*\n"
         "c\n";
     if (zsdd == -1) {
-        os << "zsdd \nE 0" << std::endl;
+        os << "zsdd \nE 0\n";
         return;
     } else if (zsdd == -2) {
-        os << "zsdd \nF 0" << std::endl;
+        os << "zsdd \nF 0\n";
         return;
     } 
     // zsdd >= 0
-    os << "zsdd " << size(zsdd) << std::endl;
+    os << "zsdd " << size(zsdd) << "\n";
     auto empty_id = zsdd_node_table_.node_array_size();
     auto false_id = empty_id + 1;
-    os << "E " << empty_id << std::endl;
-    os << "F " << false_id << std::endl;
+    os << "E " << empty_id << "\n";
+    os << "F " << false_id << "\n";
 
     std::unordered_set<addr_t> found;
     export_zsdd_txt_inner(zsdd, os, found, empty_id, false_id);
@@ -1,6 +1,11 @@
 #ifndef ZSDD_MANAGER_H_
 #define ZSDD_MANAGER_H_
 #include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <stack>
 #include <unordered_map>
@@ -15,13 +20,28 @@
 namespace zsdd {
 
 class Zsdd;
+class FrozenZsdd;
+
+// nodes reachable from a root in bottom-up order, where children are
+// referred to by positions. positions 0 and 1 are ZSDD_FALSE and
+// ZSDD_EMPTY, and nodes[i] is at position i + 2.
+struct EvaluationOrder {
+    std::vector<addr_t> nodes;
+    std::vector<int> literals;   // 0 for decompositions
+    std::vector<size_t> offsets; // elements of nodes[i] are [offsets[i], offsets[i+1])
+    std::vector<std::pair<size_t, size_t>> elements; // positions of primes and subs
+};
 
 class ZsddManager {
 public:
     ZsddManager(const VTree& vtree, const unsigned int cache_size = 1U << 16) 
         : vtree_(vtree), 
           cache_table_(cache_size),
-          zsdd_node_table_()
+          zsdd_node_table_(),
+          evaluation_order_lru_(),
+          evaluation_orders_(),
+          evaluation_orders_mutex_(),
+          variable_set_ids_()
         {}
 
 
@@ -35,10 +55,45 @@ public:
     Zsdd zsdd_change(const Zsdd& zsdd, const addr_t var);
     Zsdd zsdd_filter_contain(const Zsdd& zsdd, const addr_t var);
     Zsdd zsdd_filter_not_contain(const Zsdd& zsdd, const addr_t var);
+
+    // members with exactly / at most / at least k variables.
+    Zsdd zsdd_filter_size_eq(const Zsdd& zsdd, const int k);
+    Zsdd zsdd_filter_size_le(const Zsdd& zsdd, const int k);
+    Zsdd zsdd_filter_size_ge(const Zsdd& zsdd, const int k);
+
+    // {S \ vars | S in zsdd} and {S & keep_vars | S in zsdd} in one pass.
+    // variables out of the vtree are ignored.
+    Zsdd zsdd_exists(const Zsdd& zsdd, const std::vector<int>& vars);
+    Zsdd zsdd_project(const Zsdd& zsdd, const std::vector<int>& keep_vars);
+    // members consistent with a partial assignment: the variables of
+    // positive literals are in the member, and those of negative literals
+    // are not. one recursion handles the whole assignment. the batch
+    // version conditions zsdd by every assignment on the same cache.
+    Zsdd zsdd_condition(const Zsdd& zsdd, const std::vector<int>& assignment);
+    std::vector<Zsdd> zsdd_condition(const Zsdd& zsdd, const std::vector<std::vector<int>>& assignments);
     
+    // family algebra.
+    Zsdd zsdd_join(const Zsdd& lhs, const Zsdd& rhs);        // {a u b | a in lhs, b in rhs}
+    Zsdd zsdd_meet(const Zsdd& lhs, const Zsdd& rhs);        // {a n b | a in lhs, b in rhs}
+    Zsdd zsdd_restrict(const Zsdd& lhs, const Zsdd& rhs);    // {a in lhs | a >= b for some b in rhs}
+    Zsdd zsdd_permit(const Zsdd& lhs, const Zsdd& rhs);      // {a in lhs | a <= b for some b in rhs}
+    Zsdd zsdd_nonsuperset(const Zsdd& lhs, const Zsdd& rhs); // {a in lhs | a >= b for no b in rhs}
+    // members which are minimal (maximal) under inclusion.
+    Zsdd zsdd_minimal(const Zsdd& zsdd);
+    Zsdd zsdd_maximal(const Zsdd& zsdd);
+
     // Restore implicit partitions.
     Zsdd zsdd_to_explicit_form(const Zsdd& zsdd);
 
+    // relational tests by the apply recursion, which stop at the first
+    // witness. they make no nodes, and their cache entries are booleans.
+    // zsdds may be in either implicit or explicit form.
+    bool is_subset(const Zsdd& lhs, const Zsdd& rhs);
+    bool intersects(const Zsdd& lhs, const Zsdd& rhs);
+    bool is_disjoint(const Zsdd& lhs, const Zsdd& rhs);
+    // whether lhs and rhs have the same members.
+    bool is_equivalent(const Zsdd& lhs, const Zsdd& rhs);
+
     // increment reference counter
     void inc_zsddnode_refcount_at(const addr_t idx) {
         if (idx < 0) return;
@@ -75,16 +130,107 @@ public:
     // consists of leaves of vtree_node.
     Zsdd make_zsdd_powerset(const int vtree_node);
 
-    // model counting
+    // make zsdd of explicitly given sets in one pass: the sets are sorted
+    // and partitioned by the variables of the left and right children of
+    // each vtree node, and each decomposition node is made directly. in the
+    // flat form, set i is vars[offsets[i], offsets[i+1]).
+    Zsdd make_zsdd_from_sets(const std::vector<std::vector<int>>& sets);
+    Zsdd make_zsdd_from_sets(const std::vector<int>& vars, const std::vector<size_t>& offsets);
+
+    // model counting. count_solution stops with an error if the count
+    // doesn't fit in 64 bits. count_solution_exact picks a wide enough
+    // number type from the number of variables.
     unsigned long long count_solution(const addr_t zsdd) const;
+    std::string count_solution_exact(const addr_t zsdd) const;
+    double count_solution_log2(const addr_t zsdd) const;
+    // the number of members of each size: res[i] members have i variables.
+    // the histogram ends at the largest member and is empty for ZSDD_FALSE.
+    std::vector<unsigned long long> count_by_size(const addr_t zsdd) const;
+    std::vector<std::string> count_by_size_exact(const addr_t zsdd) const;
+
+    // weighted model counting for batch_size weight vectors in one pass.
+    // a set weighs the product of the weights of its variables. weights
+    // are variable-major: the weight of v in the w-th vector is
+    // weights[v * batch_size + w]. the log version takes and returns
+    // natural logarithms of weights.
+    std::vector<double> weighted_count(const addr_t zsdd, const std::vector<double>& weights,
+                                       const size_t batch_size) const;
+    std::vector<double> weighted_count_log(const addr_t zsdd, const std::vector<double>& log_weights,
+                                           const size_t batch_size) const;
 
     // size of zsdds.
     unsigned long long size(const addr_t zsdd) const;
+    // the member minimizing (maximizing) the sum of weights[v] of its
+    // variables, by a dp over the evaluation order. returns false if
+    // zsdd is the empty family.
+    bool min_weight_member(const addr_t zsdd, const std::vector<double>& weights,
+                           std::vector<int>& set, double& weight) const;
+    bool max_weight_member(const addr_t zsdd, const std::vector<double>& weights,
+                           std::vector<int>& set, double& weight) const;
+    // at most k members with their weights, from the least weight
+    // (the largest weight if maximize is true).
+    std::vector<std::pair<double, std::vector<int>>>
+    top_k_members(const addr_t zsdd, const std::vector<double>& weights,
+                  const size_t k, const bool maximize = false) const;
+
+    // membership test of a set of variables by one descent of the vtree.
+    bool is_member(const addr_t zsdd, const std::vector<int>& set) const;
+    // membership tests of many sets by num_threads threads.
+    std::vector<bool> is_member(const addr_t zsdd, const std::vector<std::vector<int>>& sets,
+                                const unsigned int num_threads = 1) const;
+
+    // all members of zsdd. use ZsddEnumerator for large families.
     std::vector<std::vector<int>> calc_setfamily(const addr_t zsdd) const;
 
 
     void export_zsdd_txt(const addr_t zsdd, std::ostream& os) const;
     void export_zsdd_dot(const addr_t zsdd, std::ostream& os) const;
+    // read the format of export_zsdd_txt in one pass.
+    // the file must be written with the same vtree.
+    Zsdd import_zsdd_txt(std::istream& is);
+
+    // binary format: the vtree, the nodes in bottom-up order, the roots
+    // and a checksum. the vtree of the file must be equal to vtree().
+    void save(const Zsdd& zsdd, const std::string& file_name) const;
+    void save(const std::vector<Zsdd>& zsdds, const std::string& file_name) const;
+    // the bytes written by save.
+    std::vector<unsigned char> serialize(const std::vector<Zsdd>& zsdds) const;
+    Zsdd load(const std::string& file_name);
+    std::vector<Zsdd> load_all(const std::string& file_name);
+    // the zsdds in size bytes at data written by serialize.
+    // file_name is used in error messages.
+    std::vector<Zsdd> deserialize(const unsigned char* data, const size_t size,
+                                  const std::string& file_name);
+    static VTree load_vtree(const std::string& file_name);
+
+    // copy zsdds of another manager bottom-up, sharing the common nodes.
+    // the vtree of src must be equal to vtree(), or isomorphic to it: of
+    // the same shape with the same variables, where node ids are mapped.
+    Zsdd import_from(const ZsddManager& src, const Zsdd& zsdd);
+    std::vector<Zsdd> import_from(const ZsddManager& src, const std::vector<Zsdd>& zsdds);
+
+    // a read-only snapshot of zsdds, whose queries can be called from
+    // any number of threads. it doesn't refer to the manager, which can
+    // be changed or destroyed afterwards.
+    std::shared_ptr<const FrozenZsdd> freeze(const std::vector<Zsdd>& zsdds) const;
+
+    const VTree& vtree() const { return vtree_; }
+
+    // decomposition/literal nodes reachable from roots, children before parents.
+    std::vector<addr_t> collect_nodes_bottom_up(const std::vector<addr_t>& roots) const;
+    // bottom-up order of a node for evaluate() in zsdd_evaluate.h. the
+    // orders of the last MAX_EVALUATION_ORDERS roots are cached until the
+    // next gc(). the cache is locked, so that the const queries on it
+    // (size, counts, weights, ...) can be called from many threads while
+    // the manager is not changed.
+    std::shared_ptr<const EvaluationOrder> evaluation_order(const addr_t zsdd) const;
+    // decompositions of lhs and rhs on their lowest common vtree node,
+    // where a node below it becomes a single element. returns the common
+    // vtree node. if lhs and rhs are on the same vtree node, or one of them
+    // is ZSDD_EMPTY, the other must be a decomposition node.
+    int align_decompositions(const addr_t lhs, const addr_t rhs,
+                             std::vector<ZsddElement>& decomp_l,
+                             std::vector<ZsddElement>& decomp_r) const;
 
 private:
     addr_t make_zsdd_literal_inner(const addr_t literal);
@@ -93,14 +239,37 @@ private:
                                                   new_decomp_candidates);
 
     addr_t zsdd_apply_withvar(const Operation& op, const addr_t zsdd, const addr_t var);
+    addr_t zsdd_filter_size_inner(const Operation& op, const addr_t zsdd, const int k);
+    addr_t zsdd_algebra_apply(const Operation& op, const addr_t lhs, const addr_t rhs);
+    addr_t zsdd_extremal_inner(const Operation& op, const addr_t zsdd);
+    bool intersects_inner(const addr_t lhs, const addr_t rhs);
+    bool is_subset_inner(const addr_t lhs, const addr_t rhs);
+    bool is_covered_inner(const addr_t zsdd, const addr_t node);
+    // the id of a sorted set of variables (or literals) for the computed
+    // table, so that cached results are shared between calls.
+    addr_t variable_set_id(std::vector<int>&& key);
+    // quantified[i] is the number of quantified variables among the first
+    // i leaves in dfs order, and vars_id is the interned id of the variables.
+    addr_t zsdd_exists_inner(const addr_t zsdd, const std::vector<int>& quantified,
+                             const addr_t vars_id);
+    // assigned[i] (forced_in[i]) is the number of assigned (positive)
+    // variables among the first i leaves, and assignment_id is the
+    // interned id of the assignment.
+    addr_t zsdd_condition_scope(const addr_t zsdd, const int scope, const std::vector<int>& assigned,
+                                const std::vector<int>& forced_in, const addr_t assignment_id);
+    addr_t zsdd_condition_inner(const addr_t zsdd, const std::vector<int>& assigned,
+                                const std::vector<int>& forced_in, const addr_t assignment_id);
 
 
     addr_t make_zsdd_decomposition(std::vector<ZsddElement>&& decomp_nodes, const int vtree_node);
     addr_t calc_primes_union(const std::vector<ZsddElement>& decomp);
     addr_t make_zsdd_powerset_inner(const int vtree_node);
+    // sets are positions[slices[i].first, slices[i].second), where a position
+    // is the index of a leaf in dfs order. slices are distinct and sorted so
+    // that a proper prefix comes after its extensions.
+    addr_t make_zsdd_from_sets_inner(const int vtree_node, const std::vector<int>& positions,
+                                     const std::vector<std::pair<size_t, size_t>>& slices);
 
-    unsigned long long count_solution_inner(const addr_t zsdd, std::unordered_map<addr_t, unsigned long long>& cache) const;
-    std::vector<std::vector<int>> calc_setfamily_inner(const addr_t zsdd, std::unordered_map<addr_t, std::vector<std::vector<int>>>& cache) const; 
 
     void export_zsdd_txt_inner(const addr_t zsdd, std::ostream& os, 
                                std::unordered_set<addr_t>& found, 
@@ -113,6 +282,16 @@ private:
     VTree vtree_;
     CacheTable cache_table_;
     ZsddNodeTable zsdd_node_table_;
+    // evaluation orders from the most recently used one.
+    static const size_t MAX_EVALUATION_ORDERS = 64;
+    typedef std::list<std::pair<addr_t, std::shared_ptr<const EvaluationOrder>>> EvaluationOrderList;
+    mutable EvaluationOrderList evaluation_order_lru_;
+    mutable std::unordered_map<addr_t, EvaluationOrderList::iterator> evaluation_orders_;
+    mutable std::mutex evaluation_orders_mutex_;
+    // ids of variable sets (and assignments) for the computed table. they
+    // are dropped with the cache by gc, or when there are too many of them.
+    static const size_t MAX_VARIABLE_SETS = 1U << 12;
+    std::map<std::vector<int>, addr_t> variable_set_ids_;
 
 };
 
@@ -0,0 +1,64 @@
+#ifndef ZSDD_MAPPED_FILE_H_
+#define ZSDD_MAPPED_FILE_H_
+#include <cstddef>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace zsdd {
+
+// read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), size_(0) {}
+    MappedFile(const MappedFile& obj) = delete;
+    void operator=(const MappedFile& obj) = delete;
+    ~MappedFile() { close(); }
+
+    // returns false if the file can't be opened or mapped.
+    // advice is passed to madvise.
+    bool open(const std::string& file_name, const int advice = MADV_SEQUENTIAL) {
+        close();
+        int fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                size_ = 0;
+                return false;
+            }
+            data_ = static_cast<const char*>(p);
+            madvise(p, size_, advice);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    void close() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+} // namespace zsdd
+
+#endif // ZSDD_MAPPED_FILE_H_
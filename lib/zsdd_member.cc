@@ -0,0 +1,112 @@
+#include "zsdd_manager.h"
+#include <stdint.h>
+#include <algorithm>
+#include <thread>
+
+namespace zsdd {
+
+namespace {
+
+// a set of variables as a bitset over the dfs positions of the leaves,
+// with the number of members before each word for range counting.
+class LeafBitset {
+public:
+    explicit LeafBitset(const VTree& vtree) :
+        vtree_(vtree),
+        words_((vtree.num_leaves() + 63) / 64 + 1, 0),
+        ranks_(words_.size(), 0) {}
+
+    // returns false if a variable is not in the vtree.
+    bool assign(const std::vector<int>& set) {
+        std::fill(words_.begin(), words_.end(), 0);
+        for (auto v : set) {
+            int id;
+            if (v <= 0 || !vtree_.find_literal_node_id(v, id)) return false;
+            const int pos = vtree_.leaf_begin(id);
+            words_[pos / 64] |= 1ULL << (pos % 64);
+        }
+        int r = 0;
+        for (size_t i = 0; i < words_.size(); i++) {
+            ranks_[i] = r;
+            r += __builtin_popcountll(words_[i]);
+        }
+        return true;
+    }
+
+    // the number of members in the leaves of vtree node i.
+    int count(const int i) const {
+        return rank(vtree_.leaf_end(i)) - rank(vtree_.leaf_begin(i));
+    }
+
+private:
+    const VTree& vtree_;
+    std::vector<uint64_t> words_;
+    std::vector<int> ranks_;
+
+    int rank(const int pos) const {
+        const uint64_t mask = (1ULL << (pos % 64)) - 1;
+        return ranks_[pos / 64] + __builtin_popcountll(words_[pos / 64] & mask);
+    }
+};
+
+
+// whether the set restricted to the leaves of vtree node context is in zsdd.
+bool is_member_inner(const ZsddManager& mgr, const addr_t zsdd, const int context,
+                     const LeafBitset& set) {
+    if (zsdd == ZSDD_FALSE) return false;
+    const int c = set.count(context);
+    if (zsdd == ZSDD_EMPTY) return c == 0;
+
+    const ZsddNode& n = mgr.get_zsddnode_at(zsdd);
+    const int v = n.vtree_node_id();
+    // the variables out of the vtree node of zsdd must not be in the set.
+    if (c != set.count(v)) return false;
+    if (n.type() == NodeType::LIT) {
+        return n.literal() < 0 || c == 1;
+    }
+    const VTreeNode& vn = mgr.vtree().get_node(v);
+    for (const auto& e : n.decomposition()) {
+        // primes are disjoint, so that only one prime can match. if no
+        // prime matches, the set is in the implicit part whose sub is false.
+        if (is_member_inner(mgr, e.first, vn.left_child(), set)) {
+            return is_member_inner(mgr, e.second, vn.right_child(), set);
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+
+bool ZsddManager::is_member(const addr_t zsdd, const std::vector<int>& set) const {
+    LeafBitset bits(vtree_);
+    if (!bits.assign(set)) return false;
+    return is_member_inner(*this, zsdd, vtree_.root(), bits);
+}
+
+
+std::vector<bool> ZsddManager::is_member(const addr_t zsdd, const std::vector<std::vector<int>>& sets,
+                                         const unsigned int num_threads) const {
+    // not vector<bool>, since workers write their results concurrently.
+    std::vector<char> res(sets.size(), false);
+    const size_t n = std::max<size_t>(1, std::min<size_t>(num_threads, sets.size()));
+    const size_t chunk = (sets.size() + n - 1) / n;
+    auto test = [&](const size_t t) {
+        LeafBitset bits(vtree_);
+        const size_t end = std::min(sets.size(), (t + 1) * chunk);
+        for (size_t i = t * chunk; i < end; i++) {
+            res[i] = bits.assign(sets[i]) && is_member_inner(*this, zsdd, vtree_.root(), bits);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < n; t++) {
+        workers.emplace_back(test, t);
+    }
+    test(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    return std::vector<bool>(res.begin(), res.end());
+}
+
+} // namespace zsdd
@@ -0,0 +1,227 @@
+#include "zsdd_manager.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+
+namespace zsdd {
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+
+// costs of the literal nodes of order. costs are weights, or negated
+// weights for maximization, so that the best members have the least cost.
+std::vector<double> literal_costs(const EvaluationOrder& order, const std::vector<double>& weights,
+                                  const double sign) {
+    std::vector<double> costs(order.nodes.size(), 0.0);
+    for (size_t i = 0; i < order.nodes.size(); i++) {
+        const int literal = order.literals[i];
+        if (literal == 0) continue;
+        if (static_cast<size_t>(abs(literal)) >= weights.size()) {
+            std::cerr << "[error] no weight for variable " << abs(literal) << std::endl;
+            exit(1);
+        }
+        costs[i] = sign * weights[abs(literal)];
+    }
+    return costs;
+}
+
+
+bool best_member(const ZsddManager& mgr, const addr_t zsdd, const std::vector<double>& weights,
+                 const double sign, std::vector<int>& set, double& weight) {
+    set.clear();
+    weight = 0.0;
+    if (zsdd == ZSDD_FALSE) return false;
+    if (zsdd == ZSDD_EMPTY) return true;
+
+    // bottom-up dp in the tropical semiring (min, +).
+    const std::shared_ptr<const EvaluationOrder> order = mgr.evaluation_order(zsdd);
+    const std::vector<double> lcosts = literal_costs(*order, weights, sign);
+    const size_t num_nodes = order->nodes.size();
+    std::vector<double> cost(num_nodes + 2);
+    // the best element of a decomposition, or whether a negative literal includes its variable.
+    std::vector<size_t> choice(num_nodes + 2, 0);
+    cost[0] = INF;
+    cost[1] = 0.0;
+    for (size_t i = 0; i < num_nodes; i++) {
+        const int literal = order->literals[i];
+        if (literal > 0) {
+            cost[i+2] = lcosts[i];
+        } else if (literal < 0) {
+            choice[i+2] = lcosts[i] < 0.0;
+            cost[i+2] = std::min(0.0, lcosts[i]);
+        } else {
+            cost[i+2] = INF;
+            for (size_t k = order->offsets[i]; k < order->offsets[i+1]; k++) {
+                const auto& e = order->elements[k];
+                const double c = cost[e.first] + cost[e.second];
+                if (c < cost[i+2]) {
+                    cost[i+2] = c;
+                    choice[i+2] = k;
+                }
+            }
+        }
+    }
+    weight = sign * cost.back();
+
+    std::vector<size_t> pending(1, num_nodes + 1);
+    while (!pending.empty()) {
+        const size_t pos = pending.back();
+        pending.pop_back();
+        if (pos < 2) continue;
+        const int literal = order->literals[pos-2];
+        if (literal > 0 || (literal < 0 && choice[pos])) {
+            set.push_back(abs(literal));
+        } else if (literal == 0) {
+            const auto& e = order->elements[choice[pos]];
+            pending.push_back(e.second);
+            pending.push_back(e.first);
+        }
+    }
+    return true;
+}
+
+
+// lazy k-best derivations. the r-th best member of a decomposition is
+// computed on demand from the best members of its primes and subs,
+// in the order of a best-first search over (element, prime rank, sub rank).
+class KBestSearch {
+public:
+    KBestSearch(const EvaluationOrder& order, const std::vector<double>& literal_costs) :
+        order_(order), literal_costs_(literal_costs), states_(order.nodes.size() + 2) {}
+
+    // the cost of the rank-th best member of position pos.
+    // returns false if there are not so many members.
+    bool get(const size_t pos, const size_t rank, double& cost) {
+        State& st = states_[pos];
+        if (!st.initialized) initialize(pos);
+        while (st.best.size() <= rank && !st.candidates.empty()) {
+            const Candidate c = st.candidates.top();
+            st.candidates.pop();
+            st.best.push_back(c);
+            // literals have all their candidates from the beginning.
+            if (pos < 2 || order_.literals[pos-2] != 0) continue;
+            // each (i, j) is pushed once: from (i, j-1), or from (i-1, 0) if j is 0.
+            push_candidate(st, c.element, c.prime_rank, c.sub_rank + 1);
+            if (c.sub_rank == 0) push_candidate(st, c.element, c.prime_rank + 1, 0);
+        }
+        if (st.best.size() <= rank) return false;
+        cost = st.best[rank].cost;
+        return true;
+    }
+
+    // the rank-th best member of position pos, which must be computed by get().
+    void collect(const size_t pos, const size_t rank, std::vector<int>& set) const {
+        set.clear();
+        std::vector<std::pair<size_t, size_t>> pending(1, std::make_pair(pos, rank));
+        while (!pending.empty()) {
+            const auto p = pending.back();
+            pending.pop_back();
+            if (p.first < 2) continue;
+            const Candidate& c = states_[p.first].best[p.second];
+            const int literal = order_.literals[p.first-2];
+            if (literal != 0) {
+                if (c.element == 1) set.push_back(abs(literal));
+            } else {
+                const auto& e = order_.elements[c.element];
+                pending.emplace_back(e.second, c.sub_rank);
+                pending.emplace_back(e.first, c.prime_rank);
+            }
+        }
+    }
+
+private:
+    struct Candidate {
+        double cost;
+        size_t element; // for literals, 1 if the variable is included
+        size_t prime_rank;
+        size_t sub_rank;
+        bool operator>(const Candidate& c) const { return cost > c.cost; }
+    };
+    struct State {
+        State() : initialized(false), best(), candidates() {}
+        bool initialized;
+        std::vector<Candidate> best;
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+    };
+
+    const EvaluationOrder& order_;
+    const std::vector<double>& literal_costs_;
+    std::vector<State> states_;
+
+    void initialize(const size_t pos) {
+        State& st = states_[pos];
+        st.initialized = true;
+        if (pos == 0) return;
+        if (pos == 1) {
+            st.candidates.push(Candidate{0.0, 0, 0, 0});
+            return;
+        }
+        const int literal = order_.literals[pos-2];
+        if (literal != 0) {
+            st.candidates.push(Candidate{literal_costs_[pos-2], 1, 0, 0});
+            if (literal < 0) st.candidates.push(Candidate{0.0, 0, 0, 0});
+            return;
+        }
+        for (size_t k = order_.offsets[pos-2]; k < order_.offsets[pos-1]; k++) {
+            push_candidate(st, k, 0, 0);
+        }
+    }
+
+    void push_candidate(State& st, const size_t element, const size_t prime_rank, const size_t sub_rank) {
+        const auto& e = order_.elements[element];
+        double p, s;
+        if (get(e.first, prime_rank, p) && get(e.second, sub_rank, s)) {
+            st.candidates.push(Candidate{p + s, element, prime_rank, sub_rank});
+        }
+    }
+};
+
+
+std::vector<std::pair<double, std::vector<int>>>
+k_best_members(const ZsddManager& mgr, const addr_t zsdd, const std::vector<double>& weights,
+               const size_t k, const double sign) {
+    std::vector<std::pair<double, std::vector<int>>> res;
+    if (zsdd == ZSDD_FALSE || k == 0) return res;
+    if (zsdd == ZSDD_EMPTY) {
+        res.emplace_back(0.0, std::vector<int>());
+        return res;
+    }
+    const std::shared_ptr<const EvaluationOrder> order = mgr.evaluation_order(zsdd);
+    const std::vector<double> lcosts = literal_costs(*order, weights, sign);
+    KBestSearch search(*order, lcosts);
+    const size_t root = order->nodes.size() + 1;
+    double cost;
+    for (size_t r = 0; r < k && search.get(root, r, cost); r++) {
+        res.emplace_back(sign * cost, std::vector<int>());
+        search.collect(root, r, res.back().second);
+    }
+    return res;
+}
+
+} // namespace
+
+
+bool ZsddManager::min_weight_member(const addr_t zsdd, const std::vector<double>& weights,
+                                    std::vector<int>& set, double& weight) const {
+    return best_member(*this, zsdd, weights, 1.0, set, weight);
+}
+
+
+bool ZsddManager::max_weight_member(const addr_t zsdd, const std::vector<double>& weights,
+                                    std::vector<int>& set, double& weight) const {
+    return best_member(*this, zsdd, weights, -1.0, set, weight);
+}
+
+
+std::vector<std::pair<double, std::vector<int>>>
+ZsddManager::top_k_members(const addr_t zsdd, const std::vector<double>& weights,
+                           const size_t k, const bool maximize) const {
+    return k_best_members(*this, zsdd, weights, k, maximize ? -1.0 : 1.0);
+}
+
+} // namespace zsdd
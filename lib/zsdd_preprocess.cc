@@ -0,0 +1,237 @@
+#include "zsdd_preprocess.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <numeric>
+#include <map>
+
+namespace zsdd {
+
+namespace {
+
+bool literal_less(const int lhs, const int rhs) {
+    if (abs(lhs) != abs(rhs)) return abs(lhs) < abs(rhs);
+    return lhs < rhs;
+}
+
+
+bool clause_less(const std::vector<int>& lhs, const std::vector<int>& rhs) {
+    if (lhs.size() != rhs.size()) return lhs.size() < rhs.size();
+    return std::lexicographical_compare(lhs.begin(), lhs.end(),
+                                        rhs.begin(), rhs.end(), literal_less);
+}
+
+
+size_t literal_index(const int literal) {
+    return 2 * static_cast<size_t>(abs(literal)) + (literal < 0 ? 1 : 0);
+}
+
+
+// sort literals, remove duplicated literals and tautologies.
+// returns false if the clause is a tautology.
+bool normalize_clause(std::vector<int>& clause) {
+    std::sort(clause.begin(), clause.end(), literal_less);
+    clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+    for (size_t i = 1; i < clause.size(); i++) {
+        if (abs(clause[i-1]) == abs(clause[i])) return false;
+    }
+    return true;
+}
+
+
+int find_root(std::vector<int>& parents, int v) {
+    while (parents[v] != v) {
+        parents[v] = parents[parents[v]];
+        v = parents[v];
+    }
+    return v;
+}
+
+
+class UnitPropagator {
+public:
+    UnitPropagator(const std::vector<std::vector<int>>& clauses, const int num_variables) :
+        clauses_(clauses),
+        occurrences_(2 * (num_variables + 1)),
+        assignment_(num_variables + 1, 0),
+        unassigned_count_(clauses.size()),
+        satisfied_(clauses.size(), false),
+        queue_() {
+        for (size_t i = 0; i < clauses_.size(); i++) {
+            unassigned_count_[i] = clauses_[i].size();
+            for (auto l : clauses_[i]) {
+                occurrences_[literal_index(l)].push_back(i);
+            }
+        }
+    }
+
+    // returns false on conflict.
+    bool propagate() {
+        for (size_t i = 0; i < clauses_.size(); i++) {
+            if (clauses_[i].empty()) return false;
+            if (clauses_[i].size() == 1 && !assign(clauses_[i][0])) return false;
+        }
+        for (size_t head = 0; head < queue_.size(); head++) {
+            const int l = queue_[head];
+            for (auto c : occurrences_[literal_index(l)]) {
+                satisfied_[c] = true;
+            }
+            for (auto c : occurrences_[literal_index(-l)]) {
+                if (satisfied_[c]) continue;
+                if (--unassigned_count_[c] > 1) continue;
+                if (!propagate_clause(c)) return false;
+            }
+        }
+        return true;
+    }
+
+    int value(const int var) const { return assignment_[var]; }
+    bool satisfied(const size_t c) const { return satisfied_[c]; }
+    const std::vector<int>& fixed_literals() const { return queue_; }
+
+private:
+    const std::vector<std::vector<int>>& clauses_;
+    std::vector<std::vector<size_t>> occurrences_;
+    std::vector<int> assignment_;
+    std::vector<size_t> unassigned_count_;
+    std::vector<bool> satisfied_;
+    std::vector<int> queue_;
+
+    bool assign(const int literal) {
+        const int v = abs(literal);
+        const int val = literal > 0 ? 1 : -1;
+        if (assignment_[v] != 0) return assignment_[v] == val;
+        assignment_[v] = val;
+        queue_.push_back(literal);
+        return true;
+    }
+
+    bool propagate_clause(const size_t c) {
+        int unit = 0;
+        for (auto l : clauses_[c]) {
+            const int a = assignment_[abs(l)];
+            if (a == 0) {
+                unit = l;
+            } else if ((a > 0) == (l > 0)) {
+                satisfied_[c] = true;
+                return true;
+            }
+        }
+        if (unit == 0) return false;
+        return assign(unit);
+    }
+};
+
+
+std::vector<std::vector<int>> remove_subsumed_clauses(std::vector<std::vector<int>>&& clauses,
+                                                      const int num_variables) {
+    std::sort(clauses.begin(), clauses.end(), clause_less);
+    clauses.erase(std::unique(clauses.begin(), clauses.end()), clauses.end());
+
+    std::vector<std::vector<size_t>> occurrences(2 * (num_variables + 1));
+    for (size_t i = 0; i < clauses.size(); i++) {
+        for (auto l : clauses[i]) {
+            occurrences[literal_index(l)].push_back(i);
+        }
+    }
+    // clauses are sorted by size, so that only later clauses can be subsumed.
+    std::vector<bool> removed(clauses.size(), false);
+    for (size_t i = 0; i < clauses.size(); i++) {
+        if (removed[i]) continue;
+        const auto& c = clauses[i];
+        int pivot = c[0];
+        for (auto l : c) {
+            if (occurrences[literal_index(l)].size() <
+                occurrences[literal_index(pivot)].size()) {
+                pivot = l;
+            }
+        }
+        for (auto j : occurrences[literal_index(pivot)]) {
+            if (j <= i || removed[j]) continue;
+            const auto& d = clauses[j];
+            if (d.size() > c.size() &&
+                std::includes(d.begin(), d.end(), c.begin(), c.end(), literal_less)) {
+                removed[j] = true;
+            }
+        }
+    }
+    std::vector<std::vector<int>> res;
+    for (size_t i = 0; i < clauses.size(); i++) {
+        if (!removed[i]) res.push_back(std::move(clauses[i]));
+    }
+    return res;
+}
+
+} // namespace
+
+
+PreprocessedCnf preprocess_cnf(const FnfFormula& cnf) {
+    PreprocessedCnf res;
+    res.unsat = false;
+
+    const int num_variables = cnf.num_variables();
+    std::vector<std::vector<int>> clauses;
+    for (size_t i = 0; i < cnf.size(); i++) {
+        std::vector<int> clause(cnf[i].begin(), cnf[i].end());
+        if (normalize_clause(clause)) {
+            clauses.push_back(std::move(clause));
+        }
+    }
+
+    UnitPropagator propagator(clauses, num_variables);
+    if (!propagator.propagate()) {
+        res.unsat = true;
+        return res;
+    }
+    res.fixed_literals = propagator.fixed_literals();
+
+    std::vector<std::vector<int>> reduced;
+    for (size_t i = 0; i < clauses.size(); i++) {
+        if (propagator.satisfied(i)) continue;
+        std::vector<int> clause;
+        for (auto l : clauses[i]) {
+            if (propagator.value(abs(l)) == 0) clause.push_back(l);
+        }
+        reduced.push_back(std::move(clause));
+    }
+    reduced = remove_subsumed_clauses(std::move(reduced), num_variables);
+
+    // connected components of the variable incidence graph.
+    std::vector<int> parents(num_variables + 1);
+    std::iota(parents.begin(), parents.end(), 0);
+    for (const auto& c : reduced) {
+        const int r = find_root(parents, abs(c[0]));
+        for (auto l : c) {
+            parents[find_root(parents, abs(l))] = r;
+        }
+    }
+    std::vector<bool> appeared(num_variables + 1, false);
+    std::map<int, size_t> root_component;
+    for (auto& c : reduced) {
+        const int r = find_root(parents, abs(c[0]));
+        auto it = root_component.find(r);
+        if (it == root_component.end()) {
+            it = root_component.emplace(r, res.components.size()).first;
+            res.components.emplace_back();
+            res.components.back().clauses.set_num_variables(num_variables);
+        }
+        auto& comp = res.components[it->second];
+        for (auto l : c) {
+            if (!appeared[abs(l)]) {
+                appeared[abs(l)] = true;
+                comp.variables.push_back(abs(l));
+            }
+        }
+        comp.clauses.add_clause(c.begin(), c.end());
+    }
+    for (auto& comp : res.components) {
+        std::sort(comp.variables.begin(), comp.variables.end());
+    }
+    for (int v = 1; v <= num_variables; v++) {
+        if (!appeared[v] && propagator.value(v) == 0) {
+            res.free_variables.push_back(v);
+        }
+    }
+    return res;
+}
+
+} // namespace zsdd
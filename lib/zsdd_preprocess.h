@@ -0,0 +1,30 @@
+#ifndef ZSDD_PREPROCESS_H_
+#define ZSDD_PREPROCESS_H_
+#include <vector>
+#include "zsdd_fnf.h"
+
+namespace zsdd {
+
+// a set of clauses whose variables are disjoint from the other components.
+struct CnfComponent {
+    std::vector<int> variables;
+    FnfFormula clauses;
+};
+
+struct PreprocessedCnf {
+    bool unsat;
+    // literals fixed by unit propagation.
+    std::vector<int> fixed_literals;
+    // variables that no longer appear in any clause.
+    std::vector<int> free_variables;
+    std::vector<CnfComponent> components;
+};
+
+// simplify a cnf by unit propagation, tautology/duplicate/subsumed clause
+// elimination, and split the remaining clauses into
+// variable-disjoint connected components.
+PreprocessedCnf preprocess_cnf(const FnfFormula& cnf);
+
+} // namespace zsdd
+
+#endif // ZSDD_PREPROCESS_H_
@@ -0,0 +1,130 @@
+#include "zsdd_manager.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <algorithm>
+#include "zsdd.h"
+
+namespace zsdd {
+
+namespace {
+
+// the number of quantified variables in the leaves of vtree node i.
+int count_quantified(const VTree& vtree, const std::vector<int>& quantified, const int i) {
+    return quantified[vtree.leaf_end(i)] - quantified[vtree.leaf_begin(i)];
+}
+
+} // namespace
+
+
+addr_t ZsddManager::variable_set_id(std::vector<int>&& key) {
+    // the cache is cleared with the ids, so that old ids aren't reused in it.
+    if (variable_set_ids_.size() >= MAX_VARIABLE_SETS && variable_set_ids_.count(key) == 0) {
+        variable_set_ids_.clear();
+        cache_table_.clear_cache();
+    }
+    const addr_t id = variable_set_ids_.size();
+    return variable_set_ids_.emplace(std::move(key), id).first->second;
+}
+
+
+Zsdd ZsddManager::zsdd_exists(const Zsdd& z, const std::vector<int>& vars) {
+    std::vector<char> marks(vtree_.num_leaves(), 0);
+    for (auto v : vars) {
+        int id;
+        if (v <= 0 || !vtree_.find_literal_node_id(v, id)) continue;
+        marks[vtree_.leaf_begin(id)] = 1;
+    }
+    std::vector<int> quantified(marks.size() + 1, 0);
+    std::vector<int> key;
+    for (int i = 0; i < static_cast<int>(vtree_.size()); i++) {
+        const VTreeNode& n = vtree_.get_node(i);
+        if (n.is_leaf() && marks[vtree_.leaf_begin(i)]) key.push_back(n.var());
+    }
+    for (size_t i = 0; i < marks.size(); i++) {
+        quantified[i+1] = quantified[i] + marks[i];
+    }
+    std::sort(key.begin(), key.end());
+    addr_t res = zsdd_exists_inner(z.addr(), quantified, variable_set_id(std::move(key)));
+    return Zsdd(res, *this);
+}
+
+
+Zsdd ZsddManager::zsdd_project(const Zsdd& z, const std::vector<int>& keep_vars) {
+    std::vector<char> keep(vtree_.num_leaves(), 0);
+    for (auto v : keep_vars) {
+        int id;
+        if (v <= 0 || !vtree_.find_literal_node_id(v, id)) continue;
+        keep[vtree_.leaf_begin(id)] = 1;
+    }
+    std::vector<int> vars;
+    for (int i = 0; i < static_cast<int>(vtree_.size()); i++) {
+        const VTreeNode& n = vtree_.get_node(i);
+        if (n.is_leaf() && !keep[vtree_.leaf_begin(i)]) vars.push_back(n.var());
+    }
+    return zsdd_exists(z, vars);
+}
+
+
+addr_t ZsddManager::zsdd_exists_inner(const addr_t zsdd, const std::vector<int>& quantified,
+                                      const addr_t vars_id) {
+    if (zsdd == ZSDD_FALSE || zsdd == ZSDD_EMPTY || zsdd == ZSDD_NULL) {
+        return zsdd;
+    }
+    const ZsddNode n = get_zsddnode_at(zsdd);
+    const int v = n.vtree_node_id();
+    const int c = count_quantified(vtree_, quantified, v);
+    if (c == 0) {
+        return zsdd;
+    }
+    // every variable is eliminated from a nonempty family.
+    if (c == vtree_.leaf_end(v) - vtree_.leaf_begin(v)) {
+        return ZSDD_EMPTY;
+    }
+    assert(n.type() == NodeType::DECOMP);
+
+    {
+        addr_t cache = cache_table_.read_cache(Operation::EXISTS, zsdd, vars_id);
+        if (cache != ZSDD_NULL) {
+            return cache;
+        }
+    }
+
+    const VTreeNode& vn = vtree_.get_node(v);
+    const auto& decomp = n.decomposition();
+    assert(!decomp.empty());
+    addr_t new_res = ZSDD_FALSE;
+    if (count_quantified(vtree_, quantified, vn.left_child()) == 0) {
+        // primes are kept, so that they stay disjoint.
+        std::vector<std::pair<addr_t, addr_t>> candidates;
+        for (const auto& e : decomp) {
+            addr_t new_s = zsdd_exists_inner(e.second, quantified, vars_id);
+            if (new_s == ZSDD_FALSE) continue;
+            candidates.emplace_back(e.first, new_s);
+        }
+        assert(!candidates.empty());
+        std::vector<ZsddElement> new_decomposition = compress_candidates(candidates);
+
+        // zero suppression
+        if (new_decomposition.size() == 1 && new_decomposition[0].first == ZSDD_EMPTY) {
+            new_res = new_decomposition[0].second;
+        } else if (new_decomposition.size() == 1 && new_decomposition[0].second == ZSDD_EMPTY) {
+            new_res = new_decomposition[0].first;
+        } else {
+            new_res = make_zsdd_decomposition(std::move(new_decomposition), v);
+        }
+    } else {
+        // quantified primes may overlap, so that the elements are joined
+        // and then united.
+        for (const auto& e : decomp) {
+            if (e.second == ZSDD_FALSE) continue;
+            addr_t new_p = zsdd_exists_inner(e.first, quantified, vars_id);
+            addr_t new_s = zsdd_exists_inner(e.second, quantified, vars_id);
+            addr_t joined = zsdd_apply(Operation::ORTHOGONAL_JOIN, new_p, new_s);
+            new_res = zsdd_apply(Operation::UNION, new_res, joined);
+        }
+    }
+    cache_table_.write_cache(Operation::EXISTS, zsdd, vars_id, new_res);
+    return new_res;
+}
+
+} // namespace zsdd
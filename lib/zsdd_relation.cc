@@ -0,0 +1,251 @@
+#include "zsdd_manager.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <unordered_map>
+#include "zsdd.h"
+#include "zsdd_count.h"
+
+namespace zsdd {
+
+namespace {
+
+struct AddrPairHash {
+    size_t operator()(const std::pair<addr_t, addr_t>& p) const {
+        size_t seed = std::hash<addr_t>()(p.first);
+        hash_combine(seed, std::hash<addr_t>()(p.second));
+        return seed;
+    }
+};
+
+
+// the number of common members of two zsdds without making their
+// intersection. the primes of a node are disjoint, so that the common
+// members of elements (p, s) and (p', s') are counted separately.
+template <typename T>
+class IntersectionCounter {
+public:
+    explicit IntersectionCounter(const ZsddManager& mgr) : mgr_(mgr), memo_() {}
+
+    T count(addr_t lhs, addr_t rhs) {
+        typedef CountTraits<T> Traits;
+        if (lhs > rhs) std::swap(lhs, rhs);
+        if (lhs == ZSDD_FALSE) return Traits::zero();
+        if (rhs == ZSDD_EMPTY) return Traits::one();
+        if (lhs == rhs) {
+            T c = Traits::zero();
+            count_models(mgr_, lhs, c);
+            return c;
+        }
+        const ZsddNode& r_node = mgr_.get_zsddnode_at(rhs);
+        if (r_node.type() == NodeType::LIT) {
+            if (lhs == ZSDD_EMPTY) return r_node.literal() < 0 ? Traits::one() : Traits::zero();
+            const ZsddNode& l_node = mgr_.get_zsddnode_at(lhs);
+            if (l_node.type() == NodeType::LIT) {
+                const bool both_negative = l_node.literal() < 0 && r_node.literal() < 0;
+                if (llabs(l_node.literal()) == llabs(r_node.literal())) {
+                    return both_negative ? Traits::two() : Traits::one();
+                }
+                return both_negative ? Traits::one() : Traits::zero();
+            }
+        }
+
+        const auto key = std::make_pair(lhs, rhs);
+        const auto it = memo_.find(key);
+        if (it != memo_.end()) return it->second;
+
+        std::vector<ZsddElement> decomp_l;
+        std::vector<ZsddElement> decomp_r;
+        mgr_.align_decompositions(lhs, rhs, decomp_l, decomp_r);
+        T res = Traits::zero();
+        for (const auto& l_elem : decomp_l) {
+            for (const auto& r_elem : decomp_r) {
+                const T p = count(l_elem.first, r_elem.first);
+                if (p == Traits::zero()) continue;
+                // the count fits in the exact type of the vtree.
+                Traits::add_product(res, p, count(l_elem.second, r_elem.second));
+            }
+        }
+        memo_.emplace(key, res);
+        return res;
+    }
+
+private:
+    const ZsddManager& mgr_;
+    std::unordered_map<std::pair<addr_t, addr_t>, T, AddrPairHash> memo_;
+};
+
+
+// whether zsdd is covered by the primes of node, by the sum of the
+// sizes of its intersections with the disjoint primes.
+template <typename T>
+bool covered_by_counting(const ZsddManager& mgr, const addr_t zsdd, const addr_t node) {
+    typedef CountTraits<T> Traits;
+    IntersectionCounter<T> counter(mgr);
+    T covered = Traits::zero();
+    for (const auto& e : mgr.get_zsddnode_at(node).decomposition()) {
+        Traits::add_product(covered, counter.count(zsdd, e.first), Traits::one());
+    }
+    T total = Traits::zero();
+    count_models(mgr, zsdd, total);
+    return covered == total;
+}
+
+} // namespace
+
+
+bool ZsddManager::is_subset(const Zsdd& lhs, const Zsdd& rhs) {
+    return is_subset_inner(lhs.addr(), rhs.addr());
+}
+
+
+bool ZsddManager::intersects(const Zsdd& lhs, const Zsdd& rhs) {
+    return intersects_inner(lhs.addr(), rhs.addr());
+}
+
+
+bool ZsddManager::is_disjoint(const Zsdd& lhs, const Zsdd& rhs) {
+    return !intersects_inner(lhs.addr(), rhs.addr());
+}
+
+
+bool ZsddManager::is_equivalent(const Zsdd& lhs, const Zsdd& rhs) {
+    return lhs.addr() == rhs.addr() ||
+        (is_subset_inner(lhs.addr(), rhs.addr()) && is_subset_inner(rhs.addr(), lhs.addr()));
+}
+
+
+bool ZsddManager::intersects_inner(addr_t lhs, addr_t rhs) {
+    if (lhs > rhs) std::swap(lhs, rhs);
+    if (lhs == ZSDD_FALSE || lhs == ZSDD_NULL) return false;
+    // zsdds other than ZSDD_FALSE are not empty.
+    if (lhs == rhs) return true;
+    // since rhs > lhs, rhs is always >= 0
+    const ZsddNode& r_node = get_zsddnode_at(rhs);
+    if (lhs == ZSDD_EMPTY && r_node.type() == NodeType::LIT) {
+        return r_node.literal() < 0;
+    }
+    if (lhs >= 0) {
+        const ZsddNode& l_node = get_zsddnode_at(lhs);
+        if (l_node.type() == NodeType::LIT && r_node.type() == NodeType::LIT) {
+            if (llabs(l_node.literal()) == llabs(r_node.literal())) {
+                return true;
+            }
+            return l_node.literal() < 0 && r_node.literal() < 0;
+        }
+    }
+
+    {
+        addr_t cache = cache_table_.read_cache(Operation::INTERSECTS, lhs, rhs);
+        if (cache != ZSDD_NULL) {
+            return cache == ZSDD_EMPTY;
+        }
+    }
+
+    std::vector<ZsddElement> decomp_l;
+    std::vector<ZsddElement> decomp_r;
+    align_decompositions(lhs, rhs, decomp_l, decomp_r);
+    bool res = false;
+    for (const auto& l_elem : decomp_l) {
+        for (const auto& r_elem : decomp_r) {
+            if (intersects_inner(l_elem.first, r_elem.first) &&
+                intersects_inner(l_elem.second, r_elem.second)) {
+                res = true;
+                break;
+            }
+        }
+        if (res) break;
+    }
+    cache_table_.write_cache(Operation::INTERSECTS, lhs, rhs, res ? ZSDD_EMPTY : ZSDD_FALSE);
+    return res;
+}
+
+
+bool ZsddManager::is_subset_inner(const addr_t lhs, const addr_t rhs) {
+    if (lhs == ZSDD_FALSE || lhs == ZSDD_NULL || lhs == rhs) return true;
+    if (rhs == ZSDD_FALSE || rhs == ZSDD_NULL) return false;
+    if (lhs == ZSDD_EMPTY) return intersects_inner(lhs, rhs);
+    const ZsddNode& l_node = get_zsddnode_at(lhs);
+    if (l_node.type() == NodeType::LIT) {
+        // {v} is not in zsdds without v.
+        if (rhs == ZSDD_EMPTY) return false;
+        const ZsddNode& r_node = get_zsddnode_at(rhs);
+        if (r_node.type() == NodeType::LIT) {
+            if (llabs(l_node.literal()) != llabs(r_node.literal())) return false;
+            return l_node.literal() > 0 || r_node.literal() < 0;
+        }
+    }
+
+    {
+        addr_t cache = cache_table_.read_cache(Operation::SUBSET, lhs, rhs);
+        if (cache != ZSDD_NULL) {
+            return cache == ZSDD_EMPTY;
+        }
+    }
+
+    std::vector<ZsddElement> decomp_l;
+    std::vector<ZsddElement> decomp_r;
+    align_decompositions(lhs, rhs, decomp_l, decomp_r);
+    // a member (x, y) of lhs is in rhs iff x is in a prime of rhs and
+    // y is in its sub. primes of rhs are disjoint.
+    bool res = true;
+    for (const auto& l_elem : decomp_l) {
+        if (l_elem.first == ZSDD_FALSE || l_elem.second == ZSDD_FALSE) continue;
+        for (const auto& r_elem : decomp_r) {
+            if (intersects_inner(l_elem.first, r_elem.first) &&
+                !is_subset_inner(l_elem.second, r_elem.second)) {
+                res = false;
+                break;
+            }
+        }
+        if (!res) break;
+        // the part out of the primes of rhs has the false sub.
+        if (decomp_r.size() == 1) {
+            res = is_subset_inner(l_elem.first, decomp_r[0].first);
+        } else {
+            res = is_covered_inner(l_elem.first, rhs);
+        }
+        if (!res) break;
+    }
+    cache_table_.write_cache(Operation::SUBSET, lhs, rhs, res ? ZSDD_EMPTY : ZSDD_FALSE);
+    return res;
+}
+
+
+// whether zsdd is in the union of the primes of the decomposition node.
+bool ZsddManager::is_covered_inner(const addr_t zsdd, const addr_t node) {
+    {
+        addr_t cache = cache_table_.read_cache(Operation::COVERED, zsdd, node);
+        if (cache != ZSDD_NULL) {
+            return cache == ZSDD_EMPTY;
+        }
+    }
+    bool res = false;
+    for (const auto& e : get_zsddnode_at(node).decomposition()) {
+        if (is_subset_inner(zsdd, e.first)) {
+            res = true;
+            break;
+        }
+    }
+    // zsdd may spread over some primes. the union of the primes isn't made,
+    // and the members are counted instead.
+    if (!res) {
+        const size_t num_variables = (vtree_.size() + 1) / 2;
+        switch (exact_count_type(num_variables)) {
+        case CountType::UINT64:
+            res = covered_by_counting<unsigned long long>(*this, zsdd, node);
+            break;
+#ifdef ZSDD_HAS_INT128
+        case CountType::UINT128:
+            res = covered_by_counting<uint128_t>(*this, zsdd, node);
+            break;
+#endif
+        default:
+            res = covered_by_counting<BigInt>(*this, zsdd, node);
+            break;
+        }
+    }
+    cache_table_.write_cache(Operation::COVERED, zsdd, node, res ? ZSDD_EMPTY : ZSDD_FALSE);
+    return res;
+}
+
+} // namespace zsdd
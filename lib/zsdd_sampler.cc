@@ -0,0 +1,207 @@
+#include "zsdd_sampler.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include "zsdd_frozen.h"
+#include "zsdd_manager.h"
+
+namespace zsdd {
+
+namespace {
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+// a generator whose seeding is free, for a stream per sample.
+class SplitMix64 {
+public:
+    typedef uint64_t result_type;
+    explicit SplitMix64(const uint64_t seed) : state_(seed) {}
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return std::numeric_limits<uint64_t>::max(); }
+    uint64_t operator()() {
+        state_ += 0x9e3779b97f4a7c15ULL;
+        return splitmix64(state_);
+    }
+
+private:
+    uint64_t state_;
+};
+
+
+// uniform in [0, 1) from the upper 53 bits.
+template <typename Rng>
+double uniform_real(Rng& rng) {
+    return (static_cast<uint64_t>(rng()) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+} // namespace
+
+
+ZsddSampler::ZsddSampler(const ZsddManager& mgr, const addr_t zsdd) :
+    root_(zsdd),
+    order_(zsdd >= 0 ? mgr.evaluation_order(zsdd) : nullptr),
+    cumulative_(),
+    include_probability_() {
+    build(nullptr);
+}
+
+
+ZsddSampler::ZsddSampler(const ZsddManager& mgr, const addr_t zsdd,
+                         const std::vector<double>& weights) :
+    root_(zsdd),
+    order_(zsdd >= 0 ? mgr.evaluation_order(zsdd) : nullptr),
+    cumulative_(),
+    include_probability_() {
+    build(&weights);
+}
+
+
+ZsddSampler::ZsddSampler(const FrozenZsdd& frozen, const size_t root_index) :
+    root_(frozen.root(root_index)),
+    order_(root_ >= 0 ? frozen.evaluation_order(root_index) : nullptr),
+    cumulative_(),
+    include_probability_() {
+    build(nullptr);
+}
+
+
+ZsddSampler::ZsddSampler(const FrozenZsdd& frozen, const size_t root_index,
+                         const std::vector<double>& weights) :
+    root_(frozen.root(root_index)),
+    order_(root_ >= 0 ? frozen.evaluation_order(root_index) : nullptr),
+    cumulative_(),
+    include_probability_() {
+    build(&weights);
+}
+
+
+void ZsddSampler::build(const std::vector<double>* weights) {
+    if (root_ == ZSDD_FALSE) {
+        std::cerr << "[error] can't sample from the empty family" << std::endl;
+        exit(1);
+    }
+    if (root_ == ZSDD_EMPTY) return;
+
+    const double NEG_INF = -std::numeric_limits<double>::infinity();
+    const size_t num_nodes = order_->nodes.size();
+    // log weights of positions.
+    std::vector<double> lw(num_nodes + 2);
+    lw[0] = NEG_INF;
+    lw[1] = 0.0;
+    cumulative_.assign(order_->elements.size(), 0.0);
+    include_probability_.assign(num_nodes, 0.0);
+    for (size_t i = 0; i < num_nodes; i++) {
+        const int literal = order_->literals[i];
+        if (literal != 0) {
+            double w = 1.0;
+            if (weights != nullptr) {
+                if (static_cast<size_t>(abs(literal)) >= weights->size()) {
+                    std::cerr << "[error] no weight for variable " << abs(literal) << std::endl;
+                    exit(1);
+                }
+                w = (*weights)[abs(literal)];
+            }
+            if (literal > 0) {
+                lw[i+2] = std::log(w);
+            } else {
+                lw[i+2] = std::log1p(w);
+                include_probability_[i] = w / (1.0 + w);
+            }
+            continue;
+        }
+        const size_t begin = order_->offsets[i];
+        const size_t end = order_->offsets[i+1];
+        double m = NEG_INF;
+        for (size_t k = begin; k < end; k++) {
+            const auto& e = order_->elements[k];
+            m = std::max(m, lw[e.first] + lw[e.second]);
+        }
+        if (std::isinf(m)) {
+            lw[i+2] = NEG_INF;
+            continue;
+        }
+        double total = 0.0;
+        for (size_t k = begin; k < end; k++) {
+            const auto& e = order_->elements[k];
+            total += std::exp(lw[e.first] + lw[e.second] - m);
+            cumulative_[k] = total;
+        }
+        lw[i+2] = m + std::log(total);
+    }
+    if (std::isinf(lw.back())) {
+        std::cerr << "[error] every set has zero weight" << std::endl;
+        exit(1);
+    }
+}
+
+
+void ZsddSampler::sample(std::mt19937_64& rng, std::vector<int>& set) const {
+    std::vector<size_t> pending;
+    sample_inner(rng, set, pending);
+}
+
+
+template <typename Rng>
+void ZsddSampler::sample_inner(Rng& rng, std::vector<int>& set,
+                               std::vector<size_t>& pending) const {
+    set.clear();
+    if (root_ == ZSDD_EMPTY) return;
+    pending.clear();
+    // the root is the last position.
+    pending.push_back(order_->nodes.size() + 1);
+    while (!pending.empty()) {
+        const size_t pos = pending.back();
+        pending.pop_back();
+        if (pos < 2) continue; // ZSDD_EMPTY
+        const size_t i = pos - 2;
+        const int literal = order_->literals[i];
+        if (literal > 0) {
+            set.push_back(literal);
+        } else if (literal < 0) {
+            if (uniform_real(rng) < include_probability_[i]) set.push_back(-literal);
+        } else {
+            const auto first = cumulative_.begin() + order_->offsets[i];
+            const auto last = cumulative_.begin() + order_->offsets[i+1];
+            const double r = uniform_real(rng) * last[-1];
+            // elements of zero weight have the same cumulative weight as
+            // the previous one, so that they are never chosen.
+            const size_t k = std::min(std::upper_bound(first, last, r), last - 1) - cumulative_.begin();
+            pending.push_back(order_->elements[k].second);
+            pending.push_back(order_->elements[k].first);
+        }
+    }
+}
+
+
+std::vector<std::vector<int>> ZsddSampler::sample(const size_t num_samples, const uint64_t seed,
+                                                  const unsigned int num_threads) const {
+    std::vector<std::vector<int>> res(num_samples);
+    const size_t n = std::max<size_t>(1, std::min<size_t>(num_threads, num_samples));
+    auto draw = [&](const size_t t) {
+        std::vector<size_t> pending;
+        for (size_t i = t; i < num_samples; i += n) {
+            SplitMix64 rng(seed ^ splitmix64(i));
+            sample_inner(rng, res[i], pending);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < n; t++) {
+        workers.emplace_back(draw, t);
+    }
+    draw(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    return res;
+}
+
+} // namespace zsdd
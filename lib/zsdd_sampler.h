@@ -0,0 +1,53 @@
+#ifndef ZSDD_SAMPLER_H_
+#define ZSDD_SAMPLER_H_
+#include <stdint.h>
+#include <memory>
+#include <random>
+#include <vector>
+#include "zsdd_common.h"
+
+namespace zsdd {
+
+class ZsddManager;
+class FrozenZsdd;
+struct EvaluationOrder;
+
+// draws members of a zsdd at random by descending its decompositions.
+// the probabilities of elements are computed in log space once, so
+// that a sample costs the size of the drawn derivation. the sampler
+// doesn't refer to the manager after the construction, and sampling
+// can be done from any number of threads.
+class ZsddSampler {
+public:
+    // uniform sampling.
+    ZsddSampler(const ZsddManager& mgr, const addr_t zsdd);
+    // a set is drawn with the probability proportional to the product
+    // of weights[v] of its variables. weights must be non-negative.
+    ZsddSampler(const ZsddManager& mgr, const addr_t zsdd, const std::vector<double>& weights);
+    // the same on a root of a frozen zsdd.
+    ZsddSampler(const FrozenZsdd& frozen, const size_t root_index);
+    ZsddSampler(const FrozenZsdd& frozen, const size_t root_index, const std::vector<double>& weights);
+
+    void sample(std::mt19937_64& rng, std::vector<int>& set) const;
+    // num_samples sets drawn by num_threads threads. the i-th sample
+    // depends only on seed and i, not on the number of threads. each
+    // sample uses its own splitmix64 stream, which is cheap to seed.
+    std::vector<std::vector<int>> sample(const size_t num_samples, const uint64_t seed,
+                                         const unsigned int num_threads = 1) const;
+
+private:
+    addr_t root_;
+    std::shared_ptr<const EvaluationOrder> order_;
+    // cumulative weights of the elements of a node, relative to the largest one.
+    std::vector<double> cumulative_;
+    // probabilities of {v} for negative literals.
+    std::vector<double> include_probability_;
+
+    void build(const std::vector<double>* weights);
+    template <typename Rng>
+    void sample_inner(Rng& rng, std::vector<int>& set, std::vector<size_t>& pending) const;
+};
+
+} // namespace zsdd
+
+#endif // ZSDD_SAMPLER_H_
@@ -0,0 +1,275 @@
+#include "zsdd_server.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace zsdd {
+
+namespace {
+
+bool write_fully(const int fd, const char* buf, size_t size) {
+    while (size > 0) {
+        // a closed peer is an error of the connection, not a signal.
+        const ssize_t n = send(fd, buf, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf += n;
+        size -= n;
+    }
+    return true;
+}
+
+
+// move the first frame of the bytes received on a connection to payload.
+// returns 1 if there is a whole frame, 0 if more bytes are needed, and -1
+// if the frame is too large.
+int take_frame(std::string& received, std::string& payload) {
+    if (received.size() < 4) return 0;
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(received.data());
+    const uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) |
+        (static_cast<uint32_t>(header[3]) << 24);
+    if (size > ZsddServer::MAX_FRAME_SIZE) return -1;
+    if (received.size() < 4 + static_cast<size_t>(size)) return 0;
+    payload.assign(received, 4, size);
+    received.erase(0, 4 + static_cast<size_t>(size));
+    return 1;
+}
+
+
+bool write_frame(const int fd, const std::string& payload) {
+    const uint32_t size = payload.size();
+    const unsigned char header[4] = {
+        static_cast<unsigned char>(size), static_cast<unsigned char>(size >> 8),
+        static_cast<unsigned char>(size >> 16), static_cast<unsigned char>(size >> 24)
+    };
+    return write_fully(fd, reinterpret_cast<const char*>(header), sizeof(header)) &&
+        write_fully(fd, payload.data(), payload.size());
+}
+
+
+// read integers up to the end of the stream. returns false on a malformed token.
+bool read_ints(std::istringstream& iss, std::vector<int>& values) {
+    std::string token;
+    while (iss >> token) {
+        char* end = nullptr;
+        const long v = strtol(token.c_str(), &end, 10);
+        if (*end != '\0' || v < -0x7fffffffL || v > 0x7fffffffL) return false;
+        values.push_back(v);
+    }
+    return true;
+}
+
+} // namespace
+
+
+std::string ZsddServer::handle(const std::string& request) const {
+    std::istringstream iss(request);
+    std::string command;
+    iss >> command;
+    if (command == "count") {
+        return frozen_.count_solution_exact();
+    }
+    if (command == "member" || command == "condition") {
+        std::vector<int> values;
+        if (!read_ints(iss, values)) return "error malformed literal";
+        if (command == "member") return frozen_.is_member(values) ? "1" : "0";
+        return frozen_.count_consistent_exact(values);
+    }
+    if (command == "wcount") {
+        std::vector<double> weights(frozen_.max_var() + 1, 1.0);
+        std::string token;
+        while (iss >> token) {
+            char* end = nullptr;
+            const long v = strtol(token.c_str(), &end, 10);
+            if (*end != ':' || v <= 0) return "error malformed weight " + token;
+            const double w = strtod(end + 1, &end);
+            if (*end != '\0' || !(w >= 0.0)) return "error malformed weight " + token;
+            // a variable out of the vtree is in no member.
+            if (static_cast<size_t>(v) < weights.size()) weights[v] = w;
+        }
+        std::ostringstream oss;
+        oss.precision(17);
+        oss << frozen_.weighted_count(weights);
+        return oss.str();
+    }
+    if (command == "sample") {
+        std::vector<int> values;
+        if (!read_ints(iss, values) || values.empty() || values.size() > 2 || values[0] < 0) {
+            return "error usage: sample n [seed]";
+        }
+        if (static_cast<size_t>(values[0]) > MAX_SAMPLES) return "error too many samples";
+        if (frozen_.root(0) == ZSDD_FALSE) return "error the family is empty";
+        const uint64_t seed = (values.size() == 2) ? static_cast<uint64_t>(values[1]) : std::random_device()();
+        std::ostringstream oss;
+        for (const auto& set : frozen_.sample(values[0], seed)) {
+            for (size_t i = 0; i < set.size(); i++) {
+                oss << (i == 0 ? "" : " ") << set[i];
+            }
+            oss << '\n';
+        }
+        return oss.str();
+    }
+    return "error unknown command " + command;
+}
+
+
+void ZsddServer::serve(const std::string& socket_path, const unsigned int num_threads) const {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[error] socket path is too long: " << socket_path << std::endl;
+        exit(1);
+    }
+    strcpy(addr.sun_path, socket_path.c_str());
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "[error] can't listen on " << socket_path << ": " << strerror(errno) << std::endl;
+        exit(1);
+    }
+    int wakeup[2];
+    if (pipe(wakeup) != 0 || fcntl(wakeup[0], F_SETFL, O_NONBLOCK) != 0 ||
+        fcntl(wakeup[1], F_SETFL, O_NONBLOCK) != 0) {
+        std::cerr << "[error] can't create a pipe: " << strerror(errno) << std::endl;
+        exit(1);
+    }
+    std::cerr << "serving on " << socket_path << "... threads=" << num_threads << std::endl;
+
+    // the poller reads requests without blocking and queues whole frames for
+    // the workers. a worker writes the response and hands the connection
+    // back by returned and a byte to the wakeup pipe. only the poller closes
+    // connections, so that their descriptors aren't reused while queued.
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    std::deque<std::pair<int, std::string>> ready;
+    std::vector<std::pair<int, bool>> returned; // false if the response failed
+    auto serve_requests = [&]() {
+        while (true) {
+            std::pair<int, std::string> request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready_cv.wait(lock, [&ready]() { return !ready.empty(); });
+                request = std::move(ready.front());
+                ready.pop_front();
+            }
+            const bool ok = write_frame(request.first, handle(request.second));
+            std::lock_guard<std::mutex> lock(mutex);
+            returned.emplace_back(request.first, ok);
+            // a full pipe already wakes the poller up.
+            const char c = 0;
+            if (write(wakeup[1], &c, 1) < 0 && errno != EAGAIN) {
+                std::cerr << "[error] can't wake up the poller: " << strerror(errno) << std::endl;
+                exit(1);
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < std::max(num_threads, 1U); t++) {
+        workers.emplace_back(serve_requests);
+    }
+
+    // the bytes received on each connection that are not yet a whole frame.
+    // a connection is polled unless its request is queued or being answered.
+    std::unordered_map<int, std::string> received;
+    std::vector<int> idle;
+    std::vector<pollfd> fds;
+    std::vector<char> buf(1U << 16);
+    std::string payload;
+    auto close_connection = [&received](const int fd) {
+        received.erase(fd);
+        close(fd);
+    };
+    // queue the next frame of fd, or keep polling it.
+    auto dispatch = [&](const int fd, std::vector<int>& next_idle) {
+        const int res = take_frame(received[fd], payload);
+        if (res < 0) {
+            close_connection(fd);
+        } else if (res == 0) {
+            next_idle.push_back(fd);
+        } else {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.emplace_back(fd, std::move(payload));
+            ready_cv.notify_one();
+        }
+    };
+    while (true) {
+        fds.clear();
+        fds.push_back(pollfd{listener, POLLIN, 0});
+        fds.push_back(pollfd{wakeup[0], POLLIN, 0});
+        for (auto fd : idle) {
+            fds.push_back(pollfd{fd, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[error] poll failed: " << strerror(errno) << std::endl;
+            exit(1);
+        }
+        std::vector<int> next_idle;
+        for (size_t i = 2; i < fds.size(); i++) {
+            const int fd = fds[i].fd;
+            if (fds[i].revents == 0) {
+                next_idle.push_back(fd);
+                continue;
+            }
+            const ssize_t n = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+            if (n > 0) {
+                received[fd].append(buf.data(), n);
+                dispatch(fd, next_idle);
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                next_idle.push_back(fd);
+            } else {
+                close_connection(fd);
+            }
+        }
+        if (fds[1].revents != 0) {
+            char drain[256];
+            while (read(wakeup[0], drain, sizeof(drain)) > 0) {}
+            std::vector<std::pair<int, bool>> done;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.swap(returned);
+            }
+            for (const auto& d : done) {
+                if (d.second) {
+                    // requests sent ahead may be received already.
+                    dispatch(d.first, next_idle);
+                } else {
+                    close_connection(d.first);
+                }
+            }
+        }
+        if (fds[0].revents != 0) {
+            const int fd = accept(listener, nullptr, nullptr);
+            if (fd >= 0) {
+                // a peer that doesn't read its responses releases its worker.
+                const timeval timeout = {IO_TIMEOUT_SECONDS, 0};
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                next_idle.push_back(fd);
+            } else if (errno != EINTR && errno != ECONNABORTED && errno != EAGAIN) {
+                std::cerr << "[error] accept failed: " << strerror(errno) << std::endl;
+                exit(1);
+            }
+        }
+        idle.swap(next_idle);
+    }
+}
+
+} // namespace zsdd
@@ -0,0 +1,44 @@
+#ifndef ZSDD_SERVER_H_
+#define ZSDD_SERVER_H_
+#include <stdint.h>
+#include <string>
+#include "zsdd_frozen.h"
+
+namespace zsdd {
+
+// answers queries on the first root of a frozen zsdd over a unix domain
+// socket. a request and its response are frames of a 4-byte little-endian
+// length and a text payload. requests are
+//   count                 the number of members
+//   wcount v:w ...        the weighted count (unspecified weights are 1)
+//   member v ...          1 if the set is a member, otherwise 0
+//   sample n [seed]       n members drawn uniformly, one per line
+//   condition l ...       the number of members consistent with the literals
+// and a malformed request is answered by "error ...". connections are
+// polled by one thread, which reads the requests, and each request is
+// answered by one of a fixed number of workers. the frozen zsdd is
+// read-only, so that they share it.
+class ZsddServer {
+public:
+    explicit ZsddServer(const FrozenZsdd& frozen) : frozen_(frozen) {}
+    ZsddServer(const ZsddServer&) = delete;
+    ZsddServer& operator=(const ZsddServer&) = delete;
+
+    // the response to a request payload.
+    std::string handle(const std::string& request) const;
+    // accept connections on socket_path until the process is killed.
+    // at most num_threads requests are answered at a time.
+    void serve(const std::string& socket_path, const unsigned int num_threads = 1) const;
+
+    static const uint32_t MAX_FRAME_SIZE = 1U << 24;
+    static const size_t MAX_SAMPLES = 1U << 16;
+    // a connection is closed if a response can't be written within the timeout.
+    static const int IO_TIMEOUT_SECONDS = 10;
+
+private:
+    const FrozenZsdd& frozen_;
+};
+
+} // namespace zsdd
+
+#endif // ZSDD_SERVER_H_
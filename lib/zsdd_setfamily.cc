@@ -0,0 +1,164 @@
+#include "zsdd_manager.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include "zsdd.h"
+
+namespace zsdd {
+
+namespace {
+
+// a set split at the boundary of the left and right children.
+struct SplitSet {
+    size_t begin;
+    size_t mid;
+    size_t end;
+};
+
+} // namespace
+
+
+Zsdd ZsddManager::make_zsdd_from_sets(const std::vector<std::vector<int>>& sets) {
+    std::vector<int> vars;
+    std::vector<size_t> offsets(1, 0);
+    offsets.reserve(sets.size() + 1);
+    for (const auto& s : sets) {
+        vars.insert(vars.end(), s.begin(), s.end());
+        offsets.push_back(vars.size());
+    }
+    return make_zsdd_from_sets(vars, offsets);
+}
+
+
+Zsdd ZsddManager::make_zsdd_from_sets(const std::vector<int>& vars,
+                                      const std::vector<size_t>& offsets) {
+    // dfs positions of the leaves of the variables.
+    std::vector<int> position_of;
+    for (int i = 0; i < static_cast<int>(vtree_.size()); i++) {
+        const VTreeNode& n = vtree_.get_node(i);
+        if (!n.is_leaf()) continue;
+        if (static_cast<size_t>(n.var()) >= position_of.size()) position_of.resize(n.var() + 1, -1);
+        position_of[n.var()] = vtree_.leaf_begin(i);
+    }
+    std::vector<int> positions(vars.size());
+    std::vector<std::pair<size_t, size_t>> slices;
+    slices.reserve(offsets.empty() ? 0 : offsets.size() - 1);
+    for (size_t i = 0; i + 1 < offsets.size(); i++) {
+        for (size_t k = offsets[i]; k < offsets[i+1]; k++) {
+            const int v = vars[k];
+            if (v <= 0 || static_cast<size_t>(v) >= position_of.size() || position_of[v] < 0) {
+                std::cerr << "[error] variable " << v << " is not in the vtree" << std::endl;
+                exit(1);
+            }
+            positions[k] = position_of[v];
+        }
+        const auto first = positions.begin() + offsets[i];
+        std::sort(first, positions.begin() + offsets[i+1]);
+        const auto last = std::unique(first, positions.begin() + offsets[i+1]);
+        slices.emplace_back(offsets[i], last - positions.begin());
+    }
+    // sets are sorted once so that a proper prefix comes after its
+    // extensions. then the sets with the same left part are adjacent at
+    // every vtree node, and the left parts keep the same order.
+    const auto p = positions.begin();
+    auto prefix_last = [&p](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+        size_t i = a.first;
+        size_t j = b.first;
+        for (; i < a.second && j < b.second; i++, j++) {
+            if (p[i] != p[j]) return p[i] < p[j];
+        }
+        return i < a.second;
+    };
+    auto same = [&p](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+        return a.second - a.first == b.second - b.first && std::equal(p + a.first, p + a.second, p + b.first);
+    };
+    std::sort(slices.begin(), slices.end(), prefix_last);
+    slices.erase(std::unique(slices.begin(), slices.end(), same), slices.end());
+    addr_t res = make_zsdd_from_sets_inner(vtree_.root(), positions, slices);
+    return Zsdd(res, *this);
+}
+
+
+addr_t ZsddManager::make_zsdd_from_sets_inner(const int vtree_node, const std::vector<int>& positions,
+                                              const std::vector<std::pair<size_t, size_t>>& slices) {
+    if (slices.empty()) return ZSDD_FALSE;
+    bool has_empty = false;
+    int min_position = vtree_.leaf_end(vtree_node);
+    int max_position = -1;
+    for (const auto& s : slices) {
+        if (s.first == s.second) {
+            has_empty = true;
+            continue;
+        }
+        min_position = std::min(min_position, positions[s.first]);
+        max_position = std::max(max_position, positions[s.second - 1]);
+    }
+    if (max_position < 0) return ZSDD_EMPTY;
+
+    const VTreeNode& v = vtree_.get_node(vtree_node);
+    if (v.is_leaf()) {
+        return make_zsdd_literal_inner(has_empty ? -v.var() : v.var());
+    }
+    const int left = v.left_child();
+    const int right = v.right_child();
+    const int boundary = vtree_.leaf_end(left);
+    // the sets lie in one child, whose node has no element (p, {}) or ({}, s).
+    if (max_position < boundary) {
+        return make_zsdd_from_sets_inner(left, positions, slices);
+    }
+    if (min_position >= boundary) {
+        return make_zsdd_from_sets_inner(right, positions, slices);
+    }
+
+    std::vector<SplitSet> sets;
+    sets.reserve(slices.size());
+    for (const auto& s : slices) {
+        const auto mid = std::lower_bound(positions.begin() + s.first, positions.begin() + s.second,
+                                          boundary);
+        sets.push_back(SplitSet{s.first, static_cast<size_t>(mid - positions.begin()), s.second});
+    }
+    const auto p = positions.begin();
+    auto same_left = [&p](const SplitSet& a, const SplitSet& b) {
+        return a.mid - a.begin == b.mid - b.begin && std::equal(p + a.begin, p + a.mid, p + b.begin);
+    };
+
+    // the sub of each distinct left part, and the left parts of each sub.
+    std::unordered_map<addr_t, std::vector<std::pair<size_t, size_t>>> lefts_of_sub;
+    std::vector<addr_t> subs;
+    std::vector<std::pair<size_t, size_t>> rights;
+    for (size_t i = 0; i < sets.size(); ) {
+        size_t j = i;
+        rights.clear();
+        for (; j < sets.size() && same_left(sets[i], sets[j]); j++) {
+            rights.emplace_back(sets[j].mid, sets[j].end);
+        }
+        const addr_t sub = make_zsdd_from_sets_inner(right, positions, rights);
+        auto it = lefts_of_sub.find(sub);
+        if (it == lefts_of_sub.end()) {
+            it = lefts_of_sub.emplace(sub, std::vector<std::pair<size_t, size_t>>()).first;
+            subs.push_back(sub);
+        }
+        it->second.emplace_back(sets[i].begin, sets[i].mid);
+        i = j;
+    }
+    std::vector<SplitSet>().swap(sets);
+
+    // left parts are distinct, so that primes are disjoint,
+    // and subs are distinct.
+    std::vector<ZsddElement> new_decomposition;
+    for (const auto sub : subs) {
+        const addr_t prime = make_zsdd_from_sets_inner(left, positions, lefts_of_sub.at(sub));
+        new_decomposition.emplace_back(prime, sub);
+    }
+
+    // zero suppression
+    if (new_decomposition.size() == 1) {
+        ZsddElement& e = new_decomposition[0];
+        if (e.first == ZSDD_EMPTY) return e.second;
+        if (e.second == ZSDD_EMPTY) return e.first;
+    }
+    return make_zsdd_decomposition(std::move(new_decomposition), vtree_node);
+}
+
+} // namespace zsdd
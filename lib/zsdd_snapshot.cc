@@ -0,0 +1,75 @@
+#include "zsdd_snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include "zsdd_mapped_file.h"
+
+namespace zsdd {
+
+namespace {
+
+const char SNAPSHOT_MAGIC[4] = {'Z', 'S', 'N', 'P'};
+// the magic and the fingerprint.
+const size_t SNAPSHOT_HEADER_SIZE = sizeof(SNAPSHOT_MAGIC) + 8;
+
+} // namespace
+
+
+void SnapshotWriter::write(const ZsddManager& mgr, const std::vector<Zsdd>& zsdds) {
+    wait();
+    std::vector<unsigned char> buf = mgr.serialize(zsdds);
+    unsigned char header[SNAPSHOT_HEADER_SIZE];
+    std::copy(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC), header);
+    for (int i = 0; i < 8; i++) {
+        header[sizeof(SNAPSHOT_MAGIC) + i] = static_cast<unsigned char>(fingerprint_ >> (8 * i));
+    }
+    buf.insert(buf.begin(), header, header + SNAPSHOT_HEADER_SIZE);
+    const std::string file_name = file_name_;
+    writer_ = std::thread([file_name](const std::vector<unsigned char>& buf) {
+            const std::string tmp_name = file_name + ".tmp";
+            std::ofstream ofs(tmp_name, std::ios::binary);
+            ofs.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+            ofs.close();
+            // a failed snapshot keeps the previous one, and the compilation goes on.
+            if (!ofs || rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+                std::cerr << "[error] can't write snapshot " << file_name << std::endl;
+            }
+        }, std::move(buf));
+}
+
+
+std::vector<Zsdd> SnapshotWriter::read(ZsddManager& mgr) const {
+    MappedFile file;
+    if (!file.open(file_name_)) {
+        std::cerr << "can't read " << file_name_ << std::endl;
+        exit(1);
+    }
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(file.data());
+    if (file.size() < SNAPSHOT_HEADER_SIZE ||
+        !std::equal(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC), file.data())) {
+        std::cerr << "[error] " << file_name_ << " is not a snapshot" << std::endl;
+        exit(1);
+    }
+    uint64_t fingerprint = 0;
+    for (int i = 0; i < 8; i++) {
+        fingerprint |= static_cast<uint64_t>(data[sizeof(SNAPSHOT_MAGIC) + i]) << (8 * i);
+    }
+    if (fingerprint != fingerprint_) {
+        std::cerr << "[error] snapshot " << file_name_
+                  << " was written for another input" << std::endl;
+        exit(1);
+    }
+    return mgr.deserialize(data + SNAPSHOT_HEADER_SIZE, file.size() - SNAPSHOT_HEADER_SIZE,
+                           file_name_);
+}
+
+
+void SnapshotWriter::wait() {
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+} // namespace zsdd
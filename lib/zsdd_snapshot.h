@@ -0,0 +1,43 @@
+#ifndef ZSDD_SNAPSHOT_H_
+#define ZSDD_SNAPSHOT_H_
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "zsdd.h"
+
+namespace zsdd {
+
+// writes snapshots of zsdds in the binary format of ZsddManager::save
+// by a background thread. the zsdds are serialized by the caller, which
+// is much faster than the disk, and the writer writes a temporary file
+// and renames it, so that the file always holds a complete snapshot.
+// the zsdds are preceded by a fingerprint of the input, so that a
+// snapshot is only resumed by the compilation of the same input.
+class SnapshotWriter {
+public:
+    SnapshotWriter(const std::string& file_name, const uint64_t fingerprint) :
+        file_name_(file_name), fingerprint_(fingerprint), writer_() {}
+    ~SnapshotWriter() { wait(); }
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // waits for the previous snapshot, and starts writing zsdds.
+    void write(const ZsddManager& mgr, const std::vector<Zsdd>& zsdds);
+    // waits for the last snapshot.
+    void wait();
+    // reads the zsdds of the snapshot into mgr. exits if the snapshot
+    // was written with another fingerprint.
+    std::vector<Zsdd> read(ZsddManager& mgr) const;
+
+    const std::string& file_name() const { return file_name_; }
+
+private:
+    std::string file_name_;
+    uint64_t fingerprint_;
+    std::thread writer_;
+};
+
+} // namespace zsdd
+
+#endif // ZSDD_SNAPSHOT_H_
@@ -7,6 +7,26 @@
 
 namespace zsdd {
 
+namespace {
+
+// the nodes of variables [begin, end) in preorder, so that the left child
+// of node i is i + 1 and the right child follows the left subtree.
+void construct_balanced_inner(const unsigned int begin, const unsigned int end,
+                              const int parent_id, std::vector<VTreeNode>& vtree_nodes) {
+    const int id = vtree_nodes.size();
+    if (end - begin == 1) {
+        vtree_nodes.emplace_back(begin, parent_id);
+        return;
+    }
+    const unsigned int mid = begin + (end - begin) / 2;
+    vtree_nodes.emplace_back(id + 1, id + 2 * (mid - begin), parent_id);
+    construct_balanced_inner(begin, mid, id, vtree_nodes);
+    construct_balanced_inner(mid, end, id, vtree_nodes);
+}
+
+} // namespace
+
+
 void VTree::setup_literal_vid_map() {
     literal_vid_map_.clear();
     for (int i = 0; i < (int)tree_nodes_.size(); i++) {
@@ -45,6 +65,37 @@ void VTree::setup_node_depth() {
 }
 
 
+void VTree::setup_leaf_ranges() {
+    root_ = 0;
+    for (int i = 0; i < (int)tree_nodes_.size(); i++) {
+        if (tree_nodes_[i].parent() < 0) {
+            root_ = i;
+            break;
+        }
+    }
+    int num_leaves = 0;
+    // (node, whether the children are done)
+    std::stack<std::pair<int, bool>> unexpanded;
+    unexpanded.push(std::make_pair(root_, false));
+    while (!unexpanded.empty()) {
+        auto p = unexpanded.top();
+        unexpanded.pop();
+        const VTreeNode& n = tree_nodes_[p.first];
+        if (n.is_leaf()) {
+            leaf_begin_[p.first] = num_leaves;
+            leaf_end_[p.first] = ++num_leaves;
+        } else if (!p.second) {
+            unexpanded.push(std::make_pair(p.first, true));
+            unexpanded.push(std::make_pair(n.right_child(), false));
+            unexpanded.push(std::make_pair(n.left_child(), false));
+        } else {
+            leaf_begin_[p.first] = leaf_begin_[n.left_child()];
+            leaf_end_[p.first] = leaf_end_[n.right_child()];
+        }
+    }
+}
+
+
 int VTree::get_depend_node(const int lhs_id, const int rhs_id) const {
     assert(lhs_id >= 0 && lhs_id < (int)tree_nodes_.size() &&
            rhs_id >= 0 && rhs_id < (int)tree_nodes_.size());
@@ -70,18 +121,18 @@ int VTree::get_depend_node(const int lhs_id, const int rhs_id) const {
 }
 
 
+// a node is a descendant iff its leaves are in the leaves of the ancestor.
 bool VTree::is_left_descendant(const int parent, const int child) const {
     if (tree_nodes_[parent].is_leaf()) return false;
     auto l = tree_nodes_[parent].left_child();
-    return l == get_depend_node(l, child);
+    return leaf_begin_[l] <= leaf_begin_[child] && leaf_end_[child] <= leaf_end_[l];
 }
 
 
 bool VTree::is_right_descendant(const int parent, const int child) const {
     if (tree_nodes_[parent].is_leaf()) return false;
     auto r = tree_nodes_[parent].right_child();
-
-    return r == get_depend_node(r, child);
+    return leaf_begin_[r] <= leaf_begin_[child] && leaf_end_[child] <= leaf_end_[r];
 }
 
 
@@ -107,6 +158,14 @@ int VTree::find_literal_node_id(const int literal) const {
 }
 
 
+bool VTree::find_literal_node_id(const int literal, int& id) const {
+    auto res = literal_vid_map_.find(labs(literal));
+    if (res == literal_vid_map_.end()) return false;
+    id = res->second;
+    return true;
+}
+
+
 VTree VTree::import_from_sdd_vtree_file(const std::string& file_name) {
     std::ifstream ifs(file_name);
 
@@ -169,6 +228,10 @@ VTree VTree::import_from_sdd_vtree_file(const std::string& file_name) {
 }
 
 VTree VTree::construct_right_linear_vtree(const unsigned int num_vars) {
+    if (num_vars == 0) {
+        std::cerr << "[error] a vtree needs at least one variable" << std::endl;
+        exit(1);
+    }
     std::vector<VTreeNode> vtree_nodes;
     int parent_id = -1;
     for (unsigned int i = 0; i < num_vars-1; i++) {
@@ -181,5 +244,15 @@ VTree VTree::construct_right_linear_vtree(const unsigned int num_vars) {
 }
 
 
+VTree VTree::construct_balanced_vtree(const unsigned int num_vars) {
+    if (num_vars == 0) {
+        std::cerr << "[error] a vtree needs at least one variable" << std::endl;
+        exit(1);
+    }
+    std::vector<VTreeNode> vtree_nodes;
+    vtree_nodes.reserve(2 * num_vars - 1);
+    construct_balanced_inner(1, num_vars + 1, -1, vtree_nodes);
+    return VTree(vtree_nodes);
+}
 
 } // namespace zsdd
@@ -30,6 +30,11 @@ public:
     int parent() const { return parent_;}
     int var() const { return -left_child_; }
 
+    bool operator==(const VTreeNode& n) const {
+        return left_child_ == n.left_child_ && right_child_ == n.right_child_ &&
+            parent_ == n.parent_;
+    }
+
 
     
 private:
@@ -45,34 +50,57 @@ private:
 class VTree {
 public:
     VTree(const std::vector<VTreeNode>& tree_nodes) :
-        tree_nodes_(tree_nodes), node_depth_(tree_nodes.size(),0) {
+        tree_nodes_(tree_nodes), node_depth_(tree_nodes.size(),0),
+        leaf_begin_(tree_nodes.size(), 0), leaf_end_(tree_nodes.size(), 0) {
         setup_literal_vid_map();
         setup_node_depth();
+        setup_leaf_ranges();
     }
 
     VTree(const VTree& obj) :
         tree_nodes_(obj.tree_nodes_), 
         literal_vid_map_(obj.literal_vid_map_), 
-        node_depth_(obj.node_depth_) {}
+        node_depth_(obj.node_depth_),
+        root_(obj.root_),
+        leaf_begin_(obj.leaf_begin_),
+        leaf_end_(obj.leaf_end_) {}
 
     const VTreeNode& get_node(const int i) const {
         return tree_nodes_[i];
     }
+    size_t size() const { return tree_nodes_.size(); }
+    bool operator==(const VTree& obj) const { return tree_nodes_ == obj.tree_nodes_; }
+    bool operator!=(const VTree& obj) const { return !(*this == obj); }
     int get_depend_node(const int lhs_id, const int rhs_id) const;
     bool is_left_descendant(const int parent, const int child) const;
     bool is_right_descendant(const int parent, const int child) const;
     int find_literal_node_id(const int literal) const;
+    // same as above, but returns false if the variable is not in the vtree.
+    bool find_literal_node_id(const int literal, int& id) const;
     int get_ancestor_at_depth(const int node, const int depth) const;
 
+    int root() const { return root_; }
+    // leaves are numbered in dfs order, and the leaves of
+    // the subtree of node i are [leaf_begin(i), leaf_end(i)).
+    int leaf_begin(const int i) const { return leaf_begin_[i]; }
+    int leaf_end(const int i) const { return leaf_end_[i]; }
+    int num_leaves() const { return leaf_end_[root_]; }
+
     static VTree import_from_sdd_vtree_file(const std::string& file_name);
     static VTree construct_right_linear_vtree(const unsigned int num_vars);
+    // variables 1..num_vars split in halves at every node.
+    static VTree construct_balanced_vtree(const unsigned int num_vars);
 
 private:
     const std::vector<VTreeNode> tree_nodes_;
     std::unordered_map<int, int> literal_vid_map_;
     std::vector<int> node_depth_;
+    int root_;
+    std::vector<int> leaf_begin_;
+    std::vector<int> leaf_end_;
     void setup_literal_vid_map();
     void setup_node_depth();
+    void setup_leaf_ranges();
 
 };
 
@@ -0,0 +1,106 @@
+#include "zsdd_manager.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace zsdd {
+
+namespace {
+
+// semirings on batch_size lanes. lanes of a node are contiguous,
+// so that the loops over lanes can be vectorized.
+struct LinearLanes {
+    static double zero() { return 0.0; }
+    static double one() { return 1.0; }
+    // {{}, {v}}
+    static double negative_literal(const double w) { return 1.0 + w; }
+    static void add_product(double* acc, const double* p, const double* s, const size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            acc[i] += p[i] * s[i];
+        }
+    }
+};
+
+
+struct LogLanes {
+    static double zero() { return -std::numeric_limits<double>::infinity(); }
+    static double one() { return 0.0; }
+    // log(1 + exp(w)) without overflow.
+    static double negative_literal(const double w) {
+        return w > 0.0 ? w + std::log1p(std::exp(-w)) : std::log1p(std::exp(w));
+    }
+    static void add_product(double* acc, const double* p, const double* s, const size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            const double t = p[i] + s[i];
+            const double hi = std::max(acc[i], t);
+            const double lo = std::min(acc[i], t);
+            if (!std::isinf(lo)) {
+                acc[i] = hi + std::log1p(std::exp(lo - hi));
+            } else {
+                acc[i] = hi;
+            }
+        }
+    }
+};
+
+
+template <typename Lanes>
+std::vector<double> weighted_count_batch(const ZsddManager& mgr, const addr_t zsdd,
+                                         const std::vector<double>& weights,
+                                         const size_t batch_size) {
+    if (batch_size == 0 || weights.size() % batch_size != 0) {
+        std::cerr << "[error] the number of weights must be a multiple of the batch size" << std::endl;
+        exit(1);
+    }
+    if (zsdd == ZSDD_EMPTY) return std::vector<double>(batch_size, Lanes::one());
+    if (zsdd == ZSDD_FALSE) return std::vector<double>(batch_size, Lanes::zero());
+
+    const size_t num_weighted_vars = weights.size() / batch_size;
+    const std::shared_ptr<const EvaluationOrder> order = mgr.evaluation_order(zsdd);
+    const size_t num_nodes = order->nodes.size();
+    // lanes of position i are values[i * batch_size, (i+1) * batch_size).
+    std::vector<double> values((num_nodes + 2) * batch_size, Lanes::zero());
+    std::fill(values.begin() + batch_size, values.begin() + 2 * batch_size, Lanes::one());
+    for (size_t i = 0; i < num_nodes; i++) {
+        double* acc = &values[(i + 2) * batch_size];
+        const int literal = order->literals[i];
+        if (literal != 0) {
+            const size_t v = abs(literal);
+            if (v >= num_weighted_vars) {
+                std::cerr << "[error] no weight for variable " << v << std::endl;
+                exit(1);
+            }
+            const double* w = &weights[v * batch_size];
+            for (size_t k = 0; k < batch_size; k++) {
+                acc[k] = literal < 0 ? Lanes::negative_literal(w[k]) : w[k];
+            }
+            continue;
+        }
+        for (size_t k = order->offsets[i]; k < order->offsets[i+1]; k++) {
+            const auto& e = order->elements[k];
+            Lanes::add_product(acc, &values[e.first * batch_size],
+                               &values[e.second * batch_size], batch_size);
+        }
+    }
+    // the root is the last node.
+    return std::vector<double>(values.end() - batch_size, values.end());
+}
+
+} // namespace
+
+
+std::vector<double> ZsddManager::weighted_count(const addr_t zsdd, const std::vector<double>& weights,
+                                                const size_t batch_size) const {
+    return weighted_count_batch<LinearLanes>(*this, zsdd, weights, batch_size);
+}
+
+
+std::vector<double> ZsddManager::weighted_count_log(const addr_t zsdd,
+                                                    const std::vector<double>& log_weights,
+                                                    const size_t batch_size) const {
+    return weighted_count_batch<LogLanes>(*this, zsdd, log_weights, batch_size);
+}
+
+} // namespace zsdd